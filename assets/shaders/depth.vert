@@ -1,11 +1,28 @@
 #version 330 core
 
+// VARIANTS (SEE ShaderVariant):
+// INSTANCED      - MODEL MATRIX COMES FROM INSTANCE ATTRIBUTES
+
 layout (location = 0) in vec3 a_pos;
 
-uniform mat4 light_space_matrix;
+#ifdef INSTANCED
+
+// MAT4 TAKES UP FOUR ATTRIBUTE LOCATIONS (3 TO 6)
+layout (location = 3) in mat4 a_instance_model_matrix;
+
+#define MODEL_MATRIX a_instance_model_matrix
+
+#else
+
 uniform mat4 model_matrix;
 
+#define MODEL_MATRIX model_matrix
+
+#endif
+
+uniform mat4 light_space_matrix;
+
 void main()
 {
-	gl_Position = light_space_matrix * model_matrix * vec4(a_pos, 1.0);
-}
\ No newline at end of file
+	gl_Position = light_space_matrix * MODEL_MATRIX * vec4(a_pos, 1.0);
+}
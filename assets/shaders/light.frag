@@ -1,25 +1,118 @@
 #version 330 core
 
+// VARIANTS (SEE ShaderVariant):
+// MAX_LIGHTS     - SIZE OF THE LIGHT ARRAY, AT MOST THE MAX_LIGHTS OF core.h
+// SHADOWS        - ADDS THE DIRECTIONAL LIGHT OF THE directional_light BLOCK,
+//                  SHADOWED BY ITS CASCADES IN shadow_map (SEE
+//                  ShadowCascades)
+// CLUSTERED      - READS THE POINT LIGHTS OF THE FRAGMENT'S CLUSTER FROM THE
+//                  CLUSTER TEXTURE BUFFERS (SEE LightClusters) INSTEAD OF
+//                  THE LIGHT BLOCK, MAX_LIGHTS DOES NOT APPLY
+
+#ifndef MAX_LIGHTS
 #define MAX_LIGHTS 8
+#endif
 
 out vec4 FragColor;
 
+#if defined(CLUSTERED) || defined(SHADOWS)
+
+layout(std140) uniform camera {
+    mat4 view_matrix;
+    mat4 projection_matrix;
+};
+
+#endif
+
+#ifdef CLUSTERED
+
+// (OFFSET, COUNT) INTO cluster_light_indices PER CLUSTER
+uniform usamplerBuffer cluster_grid;
+uniform usamplerBuffer cluster_light_indices;
+
+// TWO TEXELS PER LIGHT: POSITION + RADIUS, COLOR + INTENSITY
+uniform samplerBuffer cluster_lights;
+
+layout(std140) uniform clusters {
+    uvec4 cluster_grid_size;
+
+    // SLICE SCALE, SLICE BIAS, TILES PER PIXEL IN X AND Y
+    vec4 cluster_parameters;
+};
+
+#else
+
 struct LightData {
     vec4 light_position;
     vec4 light_color;
 };
 
+// THE COUNT COMES FIRST SO VARIANTS WITH A SMALLER ARRAY READ A PREFIX OF
+// THE SAME BUFFER
 layout(std140) uniform light {
-    LightData lights[MAX_LIGHTS];
     int num_lights;
+    LightData lights[MAX_LIGHTS];
 };
 
+#endif
+
 in vert_out {
     vec3 frag_pos;
 	vec3 frag_color;
     vec3 normal;
 } fs_in;
 
+#ifdef SHADOWS
+
+// SHADOW_CASCADE_COUNT OF shadow_cascades.h
+#define CASCADE_COUNT 4
+
+layout(std140) uniform directional_light {
+    mat4 cascade_matrices[CASCADE_COUNT];
+
+    // VIEW DEPTH AT WHICH EACH CASCADE ENDS, ALL ZERO WITHOUT SHADOWS
+    vec4 cascade_splits;
+    vec4 cascade_texel_sizes;
+
+    // TOWARDS THE LIGHT
+    vec4 directional_light_direction;
+    vec4 directional_light_color;
+};
+
+// ONE LAYER PER CASCADE, COMPARED IN HARDWARE
+uniform sampler2DArrayShadow shadow_map;
+
+float calculateShadow(vec3 normal, float view_depth)
+{
+    int cascade = 0;
+
+    while (cascade < CASCADE_COUNT && view_depth > cascade_splits[cascade])
+        cascade++;
+
+    // BEYOND THE SHADOW DISTANCE
+    if (cascade == CASCADE_COUNT)
+        return 0.0;
+
+    // NORMAL OFFSET, SCALED WITH THE TEXEL SIZE OF THE CASCADE
+    vec3 position = fs_in.frag_pos + normal * cascade_texel_sizes[cascade] * 1.5;
+
+    vec3 coordinates = (cascade_matrices[cascade] * vec4(position, 1.0)).xyz * 0.5 + 0.5;
+
+    // 3X3 PCF, EVERY TAP IS ALREADY A BILINEAR 2X2 COMPARISON
+    float lit = 0.0;
+    vec2 texel_size = 1.0 / vec2(textureSize(shadow_map, 0).xy);
+
+    for (int x = -1; x <= 1; ++x) {
+        for (int y = -1; y <= 1; ++y) {
+            lit += texture(shadow_map, vec4(coordinates.xy + vec2(x, y) * texel_size, float(cascade), coordinates.z));
+        }
+    }
+
+    return 1.0 - lit / 9.0;
+}
+
+#endif
+
 void main()
 {           
     vec3 normal = normalize(fs_in.normal);
@@ -36,16 +129,77 @@ void main()
 
     vec3 diffuse = vec3(0.0);
 
-    for (int i = 0; i < num_lights; i++) {
+#if defined(CLUSTERED) || defined(SHADOWS)
+    float view_depth = -(view_matrix * vec4(fs_in.frag_pos, 1.0)).z;
+#endif
+
+#ifdef CLUSTERED
+
+    // FIND THE CLUSTER, THE SLICES ARE EXPONENTIAL IN VIEW DEPTH
+    uvec3 cluster = uvec3(clamp(
+        vec3(gl_FragCoord.xy * cluster_parameters.zw,
+             log(max(view_depth, 1e-4)) * cluster_parameters.x + cluster_parameters.y),
+        vec3(0.0), vec3(cluster_grid_size.xyz - 1u)));
+
+    uint cluster_index = (cluster.z * cluster_grid_size.y + cluster.y) * cluster_grid_size.x + cluster.x;
+    uvec2 range = texelFetch(cluster_grid, int(cluster_index)).xy;
+
+    for (uint i = 0u; i < range.y; i++) {
+        int light = int(texelFetch(cluster_light_indices, int(range.x + i)).r);
+
+        vec4 light_sphere = texelFetch(cluster_lights, light * 2);
+        vec4 light_color = texelFetch(cluster_lights, light * 2 + 1);
+
+        vec3 light_vector = light_sphere.xyz - fs_in.frag_pos;
+        float light_distance = length(light_vector);
+        vec3 light_direction = light_vector / max(light_distance, 1e-4);
+
+        float light_diffuse = max(dot(normal, light_direction), 0.0);
+
+        // INVERSE SQUARE, WINDOWED TO REACH ZERO AT THE RADIUS SO LIGHTS
+        // OUTSIDE THE CLUSTER DO NOT POP
+        float falloff = light_distance / light_sphere.w;
+        falloff = clamp(1.0 - falloff * falloff * falloff * falloff, 0.0, 1.0);
+        float attenuation = falloff * falloff / (light_distance * light_distance * 0.1 + 1.0);
+
+        light_diffuse *= attenuation * light_color.w;
+
+        diffuse += light_diffuse * light_color.xyz;
+    }
+
+    // EVERY LIGHT HAS ITS OWN INTENSITY, NO AVERAGING
+    int light_count = 1;
+
+#else
+
+    int light_count = min(num_lights, MAX_LIGHTS);
+
+    for (int i = 0; i < light_count; i++) {
         vec3 light_direction = normalize(lights[i].light_position.xyz - fs_in.frag_pos);
         float light_diffuse = max(dot(normalize(normal), light_direction), 0.0); // positive only
         float light_distance = length(lights[i].light_position.xyz - fs_in.frag_pos); // further light spread
         float attenuation = 1.0 / (light_distance * light_distance * 0.1);
 
         light_diffuse *= attenuation; // light spread
+
         diffuse += light_diffuse * lights[i].light_color.xyz;
     }
 
+#endif
+
+    ///////////////////////
+    // DIRECTIONAL LIGHT //
+    ///////////////////////
+
+    vec3 directional = vec3(0.0);
+
+#ifdef SHADOWS
+    float directional_diffuse = max(dot(normal, directional_light_direction.xyz), 0.0);
+    directional_diffuse *= 1.0 - calculateShadow(normal, view_depth);
+
+    directional = directional_diffuse * directional_light_color.rgb;
+#endif
+
     ////////////////////////////////
     // quantize the diffuse color //
     ////////////////////////////////
@@ -62,7 +216,7 @@ void main()
     // vec3 specular = spec * light_color;    
     // calculate shadow
 
-    vec3 lighting = (ambient + diffuse / num_lights) * fs_in.frag_color;    
+    vec3 lighting = (ambient + diffuse / max(light_count, 1) + directional) * fs_in.frag_color;    
     // vec3 lighting = diffuse * fs_in.frag_color;    
     // vec3 lighting = fs_in.frag_color;    
     // vec3 lighting = ambient * fs_in.frag_color;
@@ -1,26 +1,71 @@
 #version 330 core
 
+// VARIANTS (SEE ShaderVariant):
+// INSTANCED      - MODEL MATRIX AND COLOR COME FROM INSTANCE ATTRIBUTES
+// VERTEX_COLORS  - THE MESH COLOR IS MULTIPLIED WITH THE OBJECT COLOR
+
+// PACKED MESH VERTICES, SEE vertex_format.h. a_normal HOLDS THE TWO
+// OCTAHEDRAL COORDINATES OF THE NORMAL
 layout (location = 0) in vec3 a_pos;
-layout (location = 1) in vec3 a_normal;
+layout (location = 1) in vec2 a_normal;
+
+#ifdef VERTEX_COLORS
+layout (location = 2) in vec3 a_color;
+#endif
+
+#ifdef INSTANCED
+
+// MAT4 TAKES UP FOUR ATTRIBUTE LOCATIONS (3 TO 6)
+layout (location = 3) in mat4 a_instance_model_matrix;
+layout (location = 7) in vec3 a_instance_color;
+
+#define MODEL_MATRIX a_instance_model_matrix
+#define OBJECT_COLOR a_instance_color
+
+#else
+
+uniform vec3 color;
+uniform mat4 model_matrix;
+
+#define MODEL_MATRIX model_matrix
+#define OBJECT_COLOR color
+
+#endif
 
 layout(std140) uniform camera {
     mat4 view_matrix;
     mat4 projection_matrix;
 };
 
-uniform vec3 color;
-uniform mat4 model_matrix;
-
 out vert_out {
     vec3 frag_pos;
 	vec3 frag_color;
     vec3 normal;
 } vs_out;
 
+vec3 decodeNormal(vec2 octahedral)
+{
+    vec3 normal = vec3(octahedral, 1.0 - abs(octahedral.x) - abs(octahedral.y));
+
+    // THE LOWER HALF IS FOLDED OVER THE DIAGONALS
+    if (normal.z < 0.0)
+    {
+        vec2 signs = vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+        normal.xy = (1.0 - abs(normal.yx)) * signs;
+    }
+
+    return normalize(normal);
+}
+
 void main()
 {
-    gl_Position = projection_matrix * view_matrix * model_matrix * vec4(a_pos, 1.0);
-    vs_out.frag_pos = vec3(model_matrix * vec4(a_pos, 1.0));
-    vs_out.normal = transpose(inverse(mat3(model_matrix))) * a_normal;
-    vs_out.frag_color = color;
-}
\ No newline at end of file
+    gl_Position = projection_matrix * view_matrix * MODEL_MATRIX * vec4(a_pos, 1.0);
+    vs_out.frag_pos = vec3(MODEL_MATRIX * vec4(a_pos, 1.0));
+    vs_out.normal = transpose(inverse(mat3(MODEL_MATRIX))) * decodeNormal(a_normal);
+
+#ifdef VERTEX_COLORS
+    vs_out.frag_color = OBJECT_COLOR * a_color;
+#else
+    vs_out.frag_color = OBJECT_COLOR;
+#endif
+}
@@ -5,5 +5,5 @@ in vec4 vert_color;
 out vec4 FragColor;
 
 void main() {
-    FragColor = vec4(1.0);
+    FragColor = vert_color;
 }
\ No newline at end of file
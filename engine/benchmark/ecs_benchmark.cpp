@@ -0,0 +1,102 @@
+/*
+ * ECS STORAGE BENCHMARK
+ *
+ * Compares the sparse-set pools against the archetype/chunk backend on the
+ * Transform + RigidBody + Mesh layout used by the cubes in Scene::Scene.
+ * Build once per backend, e.g.:
+ *
+ *   g++ -std=c++20 -O2 -Iinclude -Ineu benchmark/ecs_benchmark.cpp
+ *       neu/components/component_manager.cpp
+ *       neu/components/archetype_storage.cpp [-DNEU_ECS_ARCHETYPES]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "components/component_manager.h"
+#include "components/transform.h"
+
+using namespace Neu;
+
+// STAND-INS FOR RIGIDBODYCOMPONENT AND MESHCOMPONENT (WHICH NEED JOLT AND GL)
+struct BenchRigidBody {
+  Vector3f linearVelocity{0.0f, -1.0f, 0.0f};
+  uint32_t bodyID = 0;
+};
+
+struct BenchMesh {
+  Vector3f color{1.0f, 1.0f, 1.0f};
+  unsigned int VAO = 0;
+  unsigned int faceCount = 12;
+};
+
+template <typename Func>
+static double timeMs(Func&& func) {
+  auto start = std::chrono::high_resolution_clock::now();
+  func();
+  std::chrono::duration<double, std::milli> duration =
+      std::chrono::high_resolution_clock::now() - start;
+  return duration.count();
+}
+
+int main(int argc, char** argv) {
+  const int entityCount = argc > 1 ? std::atoi(argv[1]) : 100000;
+  const int frames = 100;
+
+#ifdef NEU_ECS_ARCHETYPES
+  printf("backend: archetype chunks (%d bytes)\n", ARCHETYPE_CHUNK_SIZE);
+#else
+  printf("backend: sparse-set pools\n");
+#endif
+
+  ComponentManager componentManager;
+
+  double createTime = timeMs([&] {
+    for (int i = 0; i < entityCount; i++) {
+      Entity entity = componentManager.createEntity();
+
+      auto& transform = componentManager.addComponent<TransformComponent>(entity);
+      transform.position = Vector3f(0.0f, 4.0f * i, 0.0f);
+
+      componentManager.addComponent<BenchRigidBody>(entity);
+      componentManager.addComponent<BenchMesh>(entity);
+    }
+  });
+
+  // SIMULATE PHYSICS WRITEBACK (RIGIDBODY -> TRANSFORM)
+  double physicsTime = timeMs([&] {
+    for (int frame = 0; frame < frames; frame++)
+      componentManager.view<BenchRigidBody, TransformComponent>().each(
+          [](Entity, BenchRigidBody& rigidBody, TransformComponent& transform) {
+            transform.position += rigidBody.linearVelocity * 0.016f;
+          });
+  });
+
+  // SIMULATE TRANSFORM SYSTEM
+  double transformTime = timeMs([&] {
+    for (int frame = 0; frame < frames; frame++)
+      for (auto [entity, transform] :
+           componentManager.view<TransformComponent>())
+        transform.transform = createTransformMatrix(
+            transform.position, transform.rotation, transform.scale);
+  });
+
+  // SIMULATE RENDER LOOP GATHER
+  float checksum = 0.0f;
+  double renderTime = timeMs([&] {
+    for (int frame = 0; frame < frames; frame++)
+      for (auto [entity, transform, mesh] :
+           componentManager.view<TransformComponent, BenchMesh>())
+        checksum += transform.transform(1, 3) * mesh.color.x;
+  });
+
+  printf("entities: %d, frames: %d\n", entityCount, frames);
+  printf("create:    %8.3f ms\n", createTime);
+  printf("physics:   %8.3f ms/frame\n", physicsTime / frames);
+  printf("transform: %8.3f ms/frame\n", transformTime / frames);
+  printf("render:    %8.3f ms/frame\n", renderTime / frames);
+  printf("(checksum %f)\n", checksum);
+
+  return 0;
+}
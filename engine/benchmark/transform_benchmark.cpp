@@ -0,0 +1,99 @@
+/*
+ * TRANSFORM BENCHMARK
+ *
+ * Compares the scalar reference createTransformMatrix path against the
+ * batched SIMD path of the TransformSystem at 1k, 10k and 100k transforms,
+ * and reports the largest difference between the two. Build with and
+ * without AVX2 to compare 4 and 8 lanes, e.g.:
+ *
+ *   g++ -std=c++20 -O2 -Iinclude -Ineu benchmark/transform_benchmark.cpp
+ *       neu/systems/transform.cpp neu/components/component_manager.cpp
+ *       neu/utility/thread_pool.cpp neu/utility/profiler.cpp
+ *       neu/utility/logger.cpp neu/utility/aabb_tree.cpp [-mavx2 -mfma]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "components/transform.h"
+#include "systems/transform.h"
+#include "utility/simd.h"
+
+using namespace Neu;
+
+template <typename Func>
+static double timeMs(Func&& func) {
+  auto start = std::chrono::high_resolution_clock::now();
+  func();
+  std::chrono::duration<double, std::milli> duration =
+      std::chrono::high_resolution_clock::now() - start;
+  return duration.count();
+}
+
+int main() {
+  const int counts[] = {1000, 10000, 100000};
+  const int frames = 100;
+
+#if defined(NEU_SIMD_AVX2)
+  printf("simd: AVX2 (8 lanes)\n");
+#elif defined(NEU_SIMD_SSE2)
+  printf("simd: SSE2 (4 lanes)\n");
+#else
+  printf("simd: none (scalar fallback)\n");
+#endif
+
+  std::mt19937 gen(1234);
+  std::uniform_real_distribution<float> positionDistribution(-100.0f, 100.0f);
+  std::uniform_real_distribution<float> angleDistribution(-10.0f, 10.0f);
+  std::uniform_real_distribution<float> scaleDistribution(0.1f, 4.0f);
+
+  for (int count : counts) {
+    std::vector<TransformComponent> components(count);
+    std::vector<TransformComponent*> transforms;
+
+    for (TransformComponent& transform : components) {
+      transform.position =
+          Vector3f(positionDistribution(gen), positionDistribution(gen),
+                   positionDistribution(gen));
+      transform.rotation =
+          Vector3f(angleDistribution(gen), angleDistribution(gen),
+                   angleDistribution(gen));
+      transform.scale = Vector3f(scaleDistribution(gen), scaleDistribution(gen),
+                                 scaleDistribution(gen));
+      transforms.push_back(&transform);
+    }
+
+    double scalarTime = timeMs([&] {
+      for (int frame = 0; frame < frames; frame++)
+        TransformSystem::updateTransformsScalar(transforms.data(), count);
+    });
+
+    std::vector<Matrix4x4f> reference;
+    for (TransformComponent& transform : components)
+      reference.push_back(transform.localTransform);
+
+    double batchedTime = timeMs([&] {
+      for (int frame = 0; frame < frames; frame++)
+        TransformSystem::updateTransforms(transforms.data(), count);
+    });
+
+    float maxError = 0.0f;
+    for (int i = 0; i < count; i++)
+      for (int row = 0; row < 4; row++)
+        for (int column = 0; column < 4; column++)
+          maxError = std::max(
+              maxError, std::abs(components[i].localTransform(row, column) -
+                                 reference[i](row, column)));
+
+    printf("transforms: %6d  scalar: %8.3f ms  batched: %8.3f ms  "
+           "speedup: %5.2fx  max error: %g\n",
+           count, scalarTime / frames, batchedTime / frames,
+           scalarTime / batchedTime, maxError);
+  }
+
+  return 0;
+}
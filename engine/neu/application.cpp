@@ -1,7 +1,13 @@
 #include "application.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "core.h"
 #include "imgui.h"
@@ -11,10 +17,15 @@
 #include "input_manager.h"
 #include "math/Matrix.h"
 #include "math/Vector.h"
+#include "render/light_clusters.h"
+#include "render/mesh_arena.h"
+#include "render/render_snapshot.h"
 #include "render/renderer.h"
+#include "render/shadow_cascades.h"
 #include "scene/scene.h"
 #include "shader_manager.h"
 #include "utility/profiler.h"
+#include "utility/thread_pool.h"
 #include "window_manager.h"
 
 using std::string;
@@ -25,13 +36,88 @@ const int height = 800;
 
 Application* Application::instance;
 
-Application::Application(int argc, char** argv) : argc(argc), argv(argv) {}
+Application::Application(int argc, char** argv) : argc(argc), argv(argv) {
+  for (int i = 1; i < argc; i++) {
+    const bool hasValue = i + 1 < argc;
+
+    if (std::strcmp(argv[i], "--headless") == 0)
+      headless = true;
+    else if (std::strcmp(argv[i], "--frames") == 0 && hasValue)
+      benchmarkFrames = std::max(std::atoi(argv[++i]), 1);
+    else if (std::strcmp(argv[i], "--warmup") == 0 && hasValue)
+      warmupFrames = std::max(std::atoi(argv[++i]), 0);
+    else if (std::strcmp(argv[i], "--delta-time") == 0 && hasValue)
+      benchmarkDeltaTime = static_cast<float>(std::atof(argv[++i]));
+    else if (std::strcmp(argv[i], "--serial") == 0)
+      pipelined = false;
+  }
+}
 
 void Application::setup() {
   assert(this == instance);
 
+  const auto setupStart = std::chrono::steady_clock::now();
+
+  // BEFORE ANY OTHER THREAD PROFILES, SO IT IS LISTED FIRST
+  Neu::Profiler::getInstance().setThreadName("Main thread");
+
   windowManager = new WindowManager(this);
-  windowManager->initialize(width, height, "neu (in-development)");
+  windowManager->initialize(width, height, "neu (in-development)", headless);
+
+  /////////////////
+  // THREAD POOL //
+  /////////////////
+
+  // THE MAIN THREAD HELPS OUT WHILE WAITING, SO LEAVE ONE CORE FOR IT. THE
+  // SHADER FILES ARE READ ON THE POOL, SO IT IS CREATED FIRST
+  unsigned int hardwareThreads = std::thread::hardware_concurrency();
+  threadPool = new ThreadPool(hardwareThreads > 1 ? hardwareThreads - 1 : 0);
+
+  /////////////
+  // SHADERS //
+  /////////////
+
+  // READ ON THE THREAD POOL AND COMPILED IN THE BACKGROUND WHERE SUPPORTED,
+  // WHILE THE REST IS SET UP
+
+#ifdef __APPLE__
+  const string shaderBasePath = "../assets/shaders/";
+#else
+  const string shaderBasePath = "../assets/shaders/";
+#endif
+
+  const string simpleVertexShaderPath = shaderBasePath + "simple.vert";
+  const string simpleFragmentShaderPath = shaderBasePath + "simple.frag";
+  const string lightVertexShaderPath = shaderBasePath + "light.vert";
+  const string lightFragmentShaderPath = shaderBasePath + "light.frag";
+  const string depthVertexShaderPath = shaderBasePath + "depth.vert";
+  const string depthFragmentShaderPath = shaderBasePath + "depth.frag";
+  const string shadowVertexShaderPath = shaderBasePath + "shadow.vert";
+  const string shadowFragmentShaderPath = shaderBasePath + "shadow.frag";
+  const string particleVertexShaderPath = shaderBasePath + "particle.vert";
+  const string particleFragmentShaderPath = shaderBasePath + "particle.frag";
+
+  // FOR LINE DRAWING
+  const string lineVertexShaderPath = shaderBasePath + "line.vert";
+  const string lineFragmentShaderPath = shaderBasePath + "line.frag";
+
+  shaderManager = new ShaderManager();
+  shaderManager->setCacheDirectory("shader_cache");
+  shaderManager->registerShader("shadow", shadowVertexShaderPath,
+                                shadowFragmentShaderPath);
+  shaderManager->registerShader("particle", particleVertexShaderPath,
+                                particleFragmentShaderPath);
+  shaderManager->registerShader("line", lineVertexShaderPath,
+                                lineFragmentShaderPath);
+
+  // BUILT PER VARIANT ON FIRST USE (INSTANCING, VERTEX COLORS, SHADOWS AND
+  // LIGHT COUNT ARE DEFINES), SEE ShaderVariant
+  shaderManager->registerShaderSource("simple", simpleVertexShaderPath,
+                                      simpleFragmentShaderPath);
+  shaderManager->registerShaderSource("light", lightVertexShaderPath,
+                                      lightFragmentShaderPath);
+  shaderManager->registerShaderSource("depth", depthVertexShaderPath,
+                                      depthFragmentShaderPath);
 
   ///////////////////
   // INPUT MANAGER //
@@ -65,80 +151,73 @@ void Application::setup() {
 
   inputManager->registerMouseAction("TOGGLE_CURSOR", Inputs::MOUSE_MIDDLE);
 
+  ////////////////
+  // MESH ARENA //
+  ////////////////
+
+  // GEOMETRY STORAGE, MUST EXIST BEFORE THE SCENE CREATES ITS MESHES
+  meshArena = new MeshArena();
+
   //////////////////
   // SET UP SCENE //
   //////////////////
 
   scene = new Scene();
 
+  // NO RESIZE EVENTS WITHOUT A WINDOW, SIZE THE CAMERA TO THE FRAMEBUFFER
+  if (headless) windowManager->notifyFramebufferSizeCallbacks(width, height);
+
   /////////////////////
   // SET UP RENDERER //
   /////////////////////
 
   renderer = new Renderer();
 
-  /////////////
-  // SHADERS //
-  /////////////
+  snapshots[0] = new RenderSnapshot();
+  snapshots[1] = new RenderSnapshot();
 
-#ifdef __APPLE__
-  const string shaderBasePath = "../assets/shaders/";
-#else
-  const string shaderBasePath = "../assets/shaders/";
-#endif
+  ///////////////////////
+  // IMGUIHELPER SETUP //
+  ///////////////////////
 
-  const string simpleVertexShaderPath = shaderBasePath + "simple.vert";
-  const string simpleFragmentShaderPath = shaderBasePath + "simple.frag";
-  const string lightVertexShaderPath = shaderBasePath + "light.vert";
-  const string lightFragmentShaderPath = shaderBasePath + "light.frag";
-  const string depthVertexShaderPath = shaderBasePath + "depth.vert";
-  const string depthFragmentShaderPath = shaderBasePath + "depth.frag";
-  const string shadowVertexShaderPath = shaderBasePath + "shadow.vert";
-  const string shadowFragmentShaderPath = shaderBasePath + "shadow.frag";
-  const string particleVertexShaderPath = shaderBasePath + "particle.vert";
-  const string particleFragmentShaderPath = shaderBasePath + "particle.frag";
+  if (!headless) {
+    imGuiHelper = new ImGuiHelper();
+    imGuiHelper->setup();
+  }
 
-  // FOR LINE DRAWING
-  const string lineVertexShaderPath = shaderBasePath + "line.vert";
-  const string lineFragmentShaderPath = shaderBasePath + "line.frag";
+  ////////////////////
+  // FINISH SHADERS //
+  ////////////////////
 
-  shaderManager = new ShaderManager();
-  shaderManager->registerShader("simple", simpleVertexShaderPath,
-                                simpleFragmentShaderPath);
-  shaderManager->registerShader("light", lightVertexShaderPath,
-                                lightFragmentShaderPath);
-  shaderManager->registerShader("depth", depthVertexShaderPath,
-                                depthFragmentShaderPath);
-  shaderManager->registerShader("shadow", shadowVertexShaderPath,
-                                shadowFragmentShaderPath);
-  shaderManager->registerShader("particle", particleVertexShaderPath,
-                                particleFragmentShaderPath);
-  shaderManager->registerShader("line", lineVertexShaderPath,
-                                lineFragmentShaderPath);
+  shaderManager->waitForShaders();
 
-  shaderManager->getShader("simple")->bindUniformBlock("camera", 0);
-  shaderManager->getShader("light")->bindUniformBlock("camera", 0);
   shaderManager->getShader("shadow")->bindUniformBlock("camera", 0);
   shaderManager->getShader("particle")->bindUniformBlock("camera", 0);
   shaderManager->getShader("line")->bindUniformBlock("camera", 0);
 
-  shaderManager->getShader("light")->bindUniformBlock("light", 1);
   // shaderManager->getShader("shadow")->bindUniformBlock("light", 1);
 
+  // ALSO BINDS THE BLOCKS OF SHADER VARIANTS AS THEY ARE BUILT
   shaderManager->createUniformBuffer("camera", 2 * sizeof(Matrix4x4f), 0);
   shaderManager->createUniformBuffer("light", sizeof(LightBuffer), 1);
+  shaderManager->createUniformBuffer("clusters", sizeof(ClusterParameters), 2);
+  shaderManager->createUniformBuffer("directional_light",
+                                     sizeof(DirectionalLightBuffer), 3);
 
   shaderManager->getShader("shadow")->setInteger("shadowMap", 0);
 
-  // todo: dynamically compile shader with number of lights (recompile shader
-  // when adding/removing light)
+  const std::chrono::duration<double, std::milli> setupDuration =
+      std::chrono::steady_clock::now() - setupStart;
 
-  ///////////////////////
-  // IMGUIHELPER SETUP //
-  ///////////////////////
+  // THE FIRST FRAME TO DRAW, FROM HERE ON THE SIMULATION STAYS ONE FRAME
+  // AHEAD OF RENDERING
+  simulate(0.0f);
+  finishSimulation();
 
-  imGuiHelper = new ImGuiHelper();
-  imGuiHelper->setup();
+  if (pipelined)
+    simulationThread = std::thread(&Application::simulationLoop, this);
+
+  Logger::info("Setup took %.1f ms\n", setupDuration.count());
 }
 
 /**
@@ -147,6 +226,11 @@ void Application::setup() {
 void Application::start() {
   // ImGuiHelper::initialize((GLFWwindow *)windowManager->getNativeWindow());
 
+  if (headless) {
+    runBenchmark();
+    return;
+  }
+
   const float fps = 60.0f;
   const float invFps = 1.0f / fps;
   float lastFrameTime = 0.0f;
@@ -157,44 +241,41 @@ void Application::start() {
     // if (currentTime - lastFrameTime < invFps)
     //     continue;
 
-    Neu::Profiler::getInstance().reset();
-
-    NEU_PROFILE_START;
-
     float deltaTime = currentTime - lastFrameTime;
     lastFrameTime = currentTime;
 
     windowManager->startFrame();
     imGuiHelper->startFrame();
 
-    // debug:
-    // deltaTime = 0.016f; // 60 fps
+    handleInput();
+
+    // THE UI READS AND EDITS THE SCENE, SO IT IS BUILT WHILE THE SIMULATION
+    // IS IDLE. THE PROFILER STILL HOLDS THE LAST COMPLETE FRAME HERE
+    imGuiHelper->show();
 
-    // DEBUGGING UPDATE (PROBLEM: MUST CLEAR COLOR AND COLOR BUFFER BITS)
-    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    Neu::Profiler::getInstance().reset();
+    Neu::GPUProfiler::getInstance().beginFrame();
 
-    update(deltaTime);
+    // SAMPLE ALONGSIDE THE PROFILER SECTIONS
+    if (Neu::Profiler::getInstance().isRecording())
+      Neu::Profiler::getInstance().setWorkerUtilization(
+          threadPool->sampleUtilization());
 
-    render();
+    NEU_PROFILE_START;
 
-    NEU_PROFILE_STOP;
+    // debug:
+    // deltaTime = 0.016f; // 60 fps
 
-    imGuiHelper->show();
+    runFrame(deltaTime);
+
+    NEU_PROFILE_STOP;
 
     imGuiHelper->endFrame();
     windowManager->endFrame();
   }
 }
 
-/**
- * This function is called every frame to update the engine context.
- */
-void Application::update(float deltaTime) {
-  // PROFILE_START;
-
-  wallTime += deltaTime;
-
+void Application::handleInput() {
   // either keep here or move to renderer (because it is fixed functionality)
   if (inputManager->isKeyActionJustPressed("TOGGLE_WIREFRAME"))
     renderer->toggleWireframe();
@@ -205,6 +286,164 @@ void Application::update(float deltaTime) {
 
   if (inputManager->isKeyActionJustPressed("CLOSE_WINDOW"))
     windowManager->closeWindow();
+}
+
+void Application::runFrame(float deltaTime) {
+  if (pipelined) {
+    simulationPending = 1;
+
+    {
+      std::lock_guard<std::mutex> lock(simulationMutex);
+      simulationDeltaTime = deltaTime;
+      simulationRequested = true;
+    }
+
+    simulationCondition.notify_one();
+  } else {
+    simulate(deltaTime);
+    finishSimulation();
+  }
+
+  // CLEARS TO THE SNAPSHOT'S BACKGROUND COLOR
+  render();
+
+  if (pipelined) {
+    NEU_PROFILE_START_CUSTOM(WaitForSimulation);
+
+    // RUNS THE SIMULATION'S TASKS MEANWHILE. THE RENDERER'S parallelFor MAY
+    // ALSO PICK UP ONE OF THEM, WHICH DELAYS THE DRAWS BY A SINGLE SYSTEM AT
+    // MOST (WITHOUT WORKERS, BOTH THREADS RUN THEIR OWN TASKS INLINE)
+    threadPool->wait(simulationPending);
+
+    NEU_PROFILE_STOP_CUSTOM(WaitForSimulation);
+
+    finishSimulation();
+  }
+}
+
+void Application::simulationLoop() {
+  bool named = false;
+
+  while (true) {
+    float deltaTime;
+
+    {
+      std::unique_lock<std::mutex> lock(simulationMutex);
+
+      simulationCondition.wait(lock, [this]() {
+        return simulationRequested || simulationStopping;
+      });
+
+      if (simulationStopping) return;
+
+      simulationRequested = false;
+      deltaTime = simulationDeltaTime;
+    }
+
+    // THE MAIN THREAD ONLY READS THE PROFILER BETWEEN FRAMES
+    if (!named) {
+      Neu::Profiler::getInstance().setThreadName("Simulation thread");
+      named = true;
+    }
+
+    simulate(deltaTime);
+    simulationPending--;
+  }
+}
+
+void Application::simulate(float deltaTime) {
+  NEU_PROFILE_FUNCTION;
+
+  update(deltaTime);
+  snapshots[1 - renderSnapshot]->extract(*scene);
+}
+
+void Application::finishSimulation() {
+  renderSnapshot = 1 - renderSnapshot;
+
+  // THE DRAWS OF THE OLD SNAPSHOT ARE ISSUED, SO THE SEGMENTS THE NEW ONE
+  // REFERS TO CAN BE FILLED
+  meshArena->uploadDynamicMeshes();
+
+  // JOLT CANNOT BE READ WHILE IT STEPS, SO THE BODIES ARE ADDED TO THE DEBUG
+  // LINES HERE, MATCHING THE NEW SNAPSHOT
+  scene->getPhysicsSystem().drawDebug(*renderer->getDebugDraw());
+}
+
+void Application::runBenchmark() {
+  Logger::info(
+      "Running %d frames (%d warmup) with a time step of %.4f s, %s\n",
+      benchmarkFrames, warmupFrames, benchmarkDeltaTime,
+      pipelined ? "pipelined" : "serial");
+
+  std::vector<double> frameTimes;
+  frameTimes.reserve(benchmarkFrames);
+
+  // THE FIRST FRAMES BUILD SHADER VARIANTS AND FILL CACHES
+  for (int frame = 0; frame < warmupFrames + benchmarkFrames; frame++) {
+    const auto frameStart = std::chrono::steady_clock::now();
+
+    Neu::Profiler::getInstance().reset();
+    Neu::GPUProfiler::getInstance().beginFrame();
+
+    NEU_PROFILE_START;
+
+    windowManager->startFrame();
+
+    runFrame(benchmarkDeltaTime);
+
+    NEU_PROFILE_STOP;
+
+    // WAITS FOR THE GPU, SO THE FRAME TIME COVERS THE WHOLE FRAME
+    windowManager->endFrame();
+
+    const std::chrono::duration<double, std::milli> frameTime =
+        std::chrono::steady_clock::now() - frameStart;
+
+    if (frame >= warmupFrames) frameTimes.push_back(frameTime.count());
+  }
+
+  ////////////////
+  // STATISTICS //
+  ////////////////
+
+  std::sort(frameTimes.begin(), frameTimes.end());
+
+  double total = 0.0;
+  for (double frameTime : frameTimes) total += frameTime;
+
+  const double mean = total / frameTimes.size();
+
+  auto percentile = [&frameTimes](double fraction) {
+    return frameTimes[std::min(frameTimes.size() - 1,
+                               static_cast<size_t>(fraction *
+                                                   frameTimes.size()))];
+  };
+
+  Logger::info("Frame times over %zu frames (ms):\n", frameTimes.size());
+  Logger::info("  mean %.3f (%.1f fps)\n", mean, 1000.0 / mean);
+  Logger::info("  min %.3f, median %.3f, p95 %.3f, p99 %.3f, max %.3f\n",
+               frameTimes.front(), percentile(0.5), percentile(0.95),
+               percentile(0.99), frameTimes.back());
+
+  // READ BACK A FEW FRAMES LATE, SO THIS IS ONE OF THE LAST FRAMES
+  const std::vector<GPUProfilerSection>& gpuSections =
+      Neu::GPUProfiler::getInstance().getResults();
+
+  if (!gpuSections.empty()) Logger::info("GPU times of a late frame (ms):\n");
+
+  for (const GPUProfilerSection& section : gpuSections)
+    Logger::info("  %*s%s %.3f\n", section.depth * 2, "", section.name,
+                 section.milliseconds);
+}
+
+/**
+ * This function is called every frame to update the engine context.
+ */
+void Application::update(float deltaTime) {
+  // PROFILE_START;
+
+  wallTime += deltaTime;
 
   scene->update(deltaTime);
 
@@ -237,7 +476,7 @@ void Application::update(float deltaTime) {
  * Renders the scene.
  */
 void Application::render() {
-  renderer->renderScene(scene);
+  renderer->renderScene(*snapshots[renderSnapshot]);
   // world->draw(&defaultShader, &depthShader, &lightShader);
 }
 
@@ -252,7 +491,33 @@ void Application::terminate() {
   // IMGUI SHUTDOWN //
   ////////////////////
 
-  imGuiHelper->shutdown();
+  if (imGuiHelper) imGuiHelper->shutdown();
+
+  ///////////////////////
+  // GPU TIMER QUERIES //
+  ///////////////////////
+
+  Neu::GPUProfiler::getInstance().shutdown();
+
+  ///////////////////////
+  // SIMULATION THREAD //
+  ///////////////////////
+
+  if (simulationThread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(simulationMutex);
+      simulationStopping = true;
+    }
+
+    simulationCondition.notify_one();
+    simulationThread.join();
+  }
+
+  /////////////////
+  // THREAD POOL //
+  /////////////////
+
+  delete threadPool;
 
   //////////
   // GLFW //
@@ -1,34 +1,66 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace Neu {
 
 class WindowManager;
 class InputManager;
 class ShaderManager;  // todo: rename to shaderregistry
 class ImGuiHelper;
+class ThreadPool;
+class MeshArena;
 
 class Scene;
 class Renderer;
+class RenderSnapshot;
 
 class Application {
  public:
+  /**
+   * Command line options:
+   *   --headless          render offscreen without a window or ImGui, run a
+   *                       fixed number of frames and log frame times
+   *   --frames N          frames to measure in headless mode (1000)
+   *   --warmup N          frames to run before measuring (10)
+   *   --delta-time S      fixed time step of every headless frame (1/60)
+   *   --serial            simulate and draw every frame on the main thread
+   *                       instead of overlapping them
+   */
   Application(int argc, char** argv);
 
   void setup();
   void start();
+
+  /**
+   * Simulates one frame. Runs on the simulation thread while the previous
+   * frame is drawn, so it must not call GL or GLFW.
+   */
   void update(float deltaTime);
+
+  /**
+   * Draws the last extracted snapshot, on the main (GL) thread.
+   */
   void render();
+
   void terminate();
 
   static Application* createInstance(int argc, char** argv);
   static Application* getInstance();
 
   Scene* getWorld() const { return scene; }
+  Renderer* getRenderer() const { return renderer; }
   float getWallTime() const { return wallTime; }
+  bool isHeadless() const { return headless; }
 
   InputManager* getInputManager() const { return inputManager; }
   WindowManager* getWindowManager() const { return windowManager; }
   ShaderManager* getShaderManager() const { return shaderManager; }
+  ThreadPool* getThreadPool() const { return threadPool; }
+  MeshArena* getMeshArena() const { return meshArena; }
 
   int getArgc() const { return argc; }
   char** getArgv() const { return argv; }
@@ -39,6 +71,69 @@ class Application {
 
   float wallTime = 0.0f;
 
+  ///////////////////
+  // HEADLESS MODE //
+  ///////////////////
+
+  bool headless = false;
+  int benchmarkFrames = 1000;
+  int warmupFrames = 10;
+  float benchmarkDeltaTime = 1.0f / 60.0f;
+
+  /**
+   * Replaces the game loop in headless mode: renders the frames with a fixed
+   * delta time into the offscreen framebuffer and logs frame time
+   * statistics.
+   */
+  void runBenchmark();
+
+  //////////////////////
+  // FRAME PIPELINING //
+  //////////////////////
+
+  bool pipelined = true;
+
+  // THE RENDERER DRAWS snapshots[renderSnapshot] WHILE THE SIMULATION
+  // EXTRACTS THE NEXT FRAME INTO THE OTHER ONE
+  RenderSnapshot* snapshots[2];
+  int renderSnapshot = 0;
+
+  std::atomic<int> simulationPending{0};
+
+  // THE SIMULATION HAS A THREAD OF ITS OWN. AS A POOL TASK IT COULD BE
+  // STOLEN BY THE MAIN THREAD WHILE THE RENDERER WAITS ON ITS RECORDING
+  // TASKS, WHICH WOULD SERIALIZE THE FRAME
+  std::thread simulationThread;
+  std::mutex simulationMutex;
+  std::condition_variable simulationCondition;
+  bool simulationRequested = false;
+  bool simulationStopping = false;
+  float simulationDeltaTime = 0.0f;
+
+  // BODY OF simulationThread, SIMULATES A FRAME WHENEVER runFrame ASKS
+  void simulationLoop();
+
+  /**
+   * Runs the input actions that call GL or GLFW, on the main thread before
+   * the simulation starts.
+   */
+  void handleInput();
+
+  /**
+   * Draws the current snapshot while the next frame is simulated (or first
+   * simulates and then draws it with --serial) and swaps the snapshots.
+   */
+  void runFrame(float deltaTime);
+
+  // UPDATES THE SCENE AND EXTRACTS IT INTO THE SNAPSHOT THAT IS NOT DRAWN
+  void simulate(float deltaTime);
+
+  /**
+   * Makes the newly extracted snapshot the one to draw and uploads the
+   * dynamic meshes it refers to. Called once the simulation is idle.
+   */
+  void finishSimulation();
+
   Scene* scene;
   Renderer* renderer;
 
@@ -46,7 +141,10 @@ class Application {
   InputManager* inputManager;
   ShaderManager* shaderManager;
 
-  ImGuiHelper* imGuiHelper;
+  ThreadPool* threadPool;
+  MeshArena* meshArena;
+
+  ImGuiHelper* imGuiHelper = nullptr;
 
   static Application* instance;
 };
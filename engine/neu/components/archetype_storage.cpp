@@ -0,0 +1,212 @@
+#include "components/archetype_storage.h"
+
+using namespace Neu;
+
+// ALIGNMENT OF THE CHUNK ALLOCATIONS (CACHE LINE)
+static constexpr size_t CHUNK_ALIGNMENT = 64;
+
+static size_t alignUp(size_t offset, size_t alignment) {
+  return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+///////////////
+// ARCHETYPE //
+///////////////
+
+Archetype::Archetype(const ComponentMask& mask,
+                     const std::vector<const ComponentInfo*>& componentInfos)
+    : mask(mask) {
+  size_t rowSize = sizeof(Entity);
+
+  for (ComponentTypeID typeID = 0; typeID < MAX_COMPONENT_TYPES; typeID++) {
+    if (!mask.test(typeID)) continue;
+
+    types.push_back(typeID);
+    infos[typeID] = componentInfos[typeID];
+    rowSize += infos[typeID]->size;
+
+    assert(infos[typeID]->alignment <= CHUNK_ALIGNMENT);
+  }
+
+  // FIT AS MANY ROWS AS POSSIBLE, ACCOUNTING FOR COLUMN ALIGNMENT PADDING
+  chunkCapacity = static_cast<uint32_t>(ARCHETYPE_CHUNK_SIZE / rowSize);
+
+  for (; chunkCapacity > 0; chunkCapacity--) {
+    size_t offset = chunkCapacity * sizeof(Entity);
+
+    for (ComponentTypeID typeID : types) {
+      offset = alignUp(offset, infos[typeID]->alignment);
+      columnOffsets[typeID] = static_cast<uint32_t>(offset);
+      offset += chunkCapacity * infos[typeID]->size;
+    }
+
+    if (offset <= ARCHETYPE_CHUNK_SIZE) break;
+  }
+
+  assert(chunkCapacity > 0 && "Components do not fit in an archetype chunk");
+}
+
+Archetype::~Archetype() {
+  for (ArchetypeChunk& chunk : chunks) {
+    for (ComponentTypeID typeID : types)
+      for (uint32_t row = 0; row < chunk.count; row++)
+        infos[typeID]->destroy(getComponent(
+            static_cast<uint32_t>(&chunk - chunks.data()), row, typeID));
+
+    ::operator delete(chunk.data, std::align_val_t(CHUNK_ALIGNMENT));
+  }
+}
+
+std::pair<uint32_t, uint32_t> Archetype::allocateRow(Entity entity) {
+  if (chunks.empty() || chunks.back().count == chunkCapacity) {
+    ArchetypeChunk chunk;
+    chunk.data = static_cast<std::byte*>(::operator new(
+        ARCHETYPE_CHUNK_SIZE, std::align_val_t(CHUNK_ALIGNMENT)));
+    chunks.push_back(chunk);
+  }
+
+  uint32_t chunk = static_cast<uint32_t>(chunks.size() - 1);
+  uint32_t row = chunks[chunk].count++;
+
+  getEntities(chunks[chunk])[row] = entity;
+
+  return {chunk, row};
+}
+
+Entity Archetype::removeRow(uint32_t chunk, uint32_t row) {
+  uint32_t lastChunk = static_cast<uint32_t>(chunks.size() - 1);
+  uint32_t lastRow = chunks[lastChunk].count - 1;
+
+  Entity movedEntity = NULL_ENTITY;
+
+  // KEEP CHUNKS PACKED BY MOVING THE LAST ROW INTO THE HOLE
+  if (chunk != lastChunk || row != lastRow) {
+    for (ComponentTypeID typeID : types) {
+      void* source = getComponent(lastChunk, lastRow, typeID);
+      infos[typeID]->moveConstruct(getComponent(chunk, row, typeID), source);
+      infos[typeID]->destroy(source);
+    }
+
+    movedEntity = getEntities(chunks[lastChunk])[lastRow];
+    getEntities(chunks[chunk])[row] = movedEntity;
+  }
+
+  if (--chunks[lastChunk].count == 0) {
+    ::operator delete(chunks[lastChunk].data,
+                      std::align_val_t(CHUNK_ALIGNMENT));
+    chunks.pop_back();
+  }
+
+  return movedEntity;
+}
+
+///////////////////////
+// ARCHETYPE STORAGE //
+///////////////////////
+
+ArchetypeStorage::~ArchetypeStorage() {
+  // ARCHETYPES DESTROY THEIR REMAINING COMPONENTS
+  archetypes.clear();
+}
+
+void ArchetypeStorage::createEntity(Entity entity) {
+  if (entity >= locations.size()) locations.resize(entity + 1);
+}
+
+void ArchetypeStorage::destroyEntity(Entity entity) {
+  if (entity >= locations.size() || !locations[entity].archetype) return;
+
+  EntityLocation& location = locations[entity];
+
+  for (ComponentTypeID typeID : location.archetype->getTypes())
+    infos[typeID]->destroy(location.archetype->getComponent(
+        location.chunk, location.row, typeID));
+
+  removeFromArchetype(location);
+  location = EntityLocation();
+}
+
+Archetype* ArchetypeStorage::getArchetype(const ComponentMask& mask) {
+  auto it = archetypes.find(mask);
+  if (it != archetypes.end()) return it->second.get();
+
+  Archetype* archetype = new Archetype(mask, infos);
+  archetypes[mask] = std::unique_ptr<Archetype>(archetype);
+  archetypeList.push_back(archetype);
+
+  return archetype;
+}
+
+ArchetypeStorage::EntityLocation& ArchetypeStorage::moveEntity(
+    Entity entity, ComponentTypeID typeID, bool add) {
+  EntityLocation& location = locations[entity];
+  Archetype* source = location.archetype;
+
+  ////////////////////////////////
+  // FIND DESTINATION ARCHETYPE //
+  ////////////////////////////////
+
+  ComponentMask mask = source ? source->getMask() : ComponentMask();
+  mask.set(typeID, add);
+
+  Archetype* destination = nullptr;
+
+  if (mask.any()) {
+    if (source) {
+      auto& edges = add ? source->addEdges : source->removeEdges;
+      auto it = edges.find(typeID);
+
+      if (it != edges.end()) {
+        destination = it->second;
+      } else {
+        destination = getArchetype(mask);
+        edges[typeID] = destination;
+      }
+    } else {
+      destination = getArchetype(mask);
+    }
+  }
+
+  /////////////////////////
+  // RELOCATE COMPONENTS //
+  /////////////////////////
+
+  EntityLocation newLocation;
+  newLocation.archetype = destination;
+
+  if (destination) {
+    auto [chunk, row] = destination->allocateRow(entity);
+    newLocation.chunk = chunk;
+    newLocation.row = row;
+  }
+
+  if (source) {
+    for (ComponentTypeID sourceType : source->getTypes()) {
+      void* component =
+          source->getComponent(location.chunk, location.row, sourceType);
+
+      if (destination && destination->getMask().test(sourceType))
+        infos[sourceType]->moveConstruct(
+            destination->getComponent(newLocation.chunk, newLocation.row,
+                                      sourceType),
+            component);
+
+      infos[sourceType]->destroy(component);
+    }
+
+    removeFromArchetype(location);
+  }
+
+  location = newLocation;
+  return location;
+}
+
+void ArchetypeStorage::removeFromArchetype(const EntityLocation& location) {
+  Entity movedEntity =
+      location.archetype->removeRow(location.chunk, location.row);
+
+  if (movedEntity != NULL_ENTITY) {
+    locations[movedEntity].chunk = location.chunk;
+    locations[movedEntity].row = location.row;
+  }
+}
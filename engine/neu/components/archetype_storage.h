@@ -0,0 +1,337 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "components/component_type.h"
+
+namespace Neu {
+
+// SIZE OF A SINGLE ARCHETYPE CHUNK
+#define ARCHETYPE_CHUNK_SIZE (16 * 1024)
+
+/**
+ * Type-erased operations the archetype storage needs to relocate and destroy
+ * components it only knows by ID.
+ */
+struct ComponentInfo {
+  size_t size;
+  size_t alignment;
+  void (*moveConstruct)(void* destination, void* source);
+  void (*destroy)(void* component);
+};
+
+template <typename T>
+const ComponentInfo* getComponentInfo() {
+  static const ComponentInfo info{
+      sizeof(T), alignof(T),
+      [](void* destination, void* source) {
+        new (destination) T(std::move(*static_cast<T*>(source)));
+      },
+      [](void* component) { static_cast<T*>(component)->~T(); }};
+  return &info;
+}
+
+/**
+ * Fixed-size block of memory holding up to Archetype::chunkCapacity entities.
+ * The block is laid out as structure-of-arrays: one array of entities
+ * followed by one tightly packed array per component type.
+ */
+struct ArchetypeChunk {
+  std::byte* data = nullptr;
+  uint32_t count = 0;
+};
+
+/**
+ * All entities that own exactly the same set of components.
+ */
+class Archetype {
+ public:
+  Archetype(const ComponentMask& mask,
+            const std::vector<const ComponentInfo*>& infos);
+  ~Archetype();
+
+  Archetype(const Archetype&) = delete;
+  Archetype& operator=(const Archetype&) = delete;
+
+  const ComponentMask& getMask() const { return mask; }
+  const std::vector<ComponentTypeID>& getTypes() const { return types; }
+  std::vector<ArchetypeChunk>& getChunks() { return chunks; }
+  uint32_t getChunkCapacity() const { return chunkCapacity; }
+
+  Entity* getEntities(const ArchetypeChunk& chunk) const {
+    return reinterpret_cast<Entity*>(chunk.data);
+  }
+
+  void* getColumn(const ArchetypeChunk& chunk, ComponentTypeID typeID) const {
+    return chunk.data + columnOffsets[typeID];
+  }
+
+  template <typename T>
+  T* getColumn(const ArchetypeChunk& chunk) const {
+    return static_cast<T*>(getColumn(chunk, componentTypeID<T>));
+  }
+
+  void* getComponent(uint32_t chunk, uint32_t row,
+                     ComponentTypeID typeID) const {
+    return static_cast<std::byte*>(getColumn(chunks[chunk], typeID)) +
+           row * infos[typeID]->size;
+  }
+
+  /**
+   * Reserves a row at the end of the archetype for the entity. The components
+   * in the row are left unconstructed.
+   */
+  std::pair<uint32_t, uint32_t> allocateRow(Entity entity);
+
+  /**
+   * Fills the hole at (chunk, row) with the last row of the archetype. The
+   * components in the hole must already be destroyed or moved from. Returns
+   * the entity that was moved into the hole, or NULL_ENTITY.
+   */
+  Entity removeRow(uint32_t chunk, uint32_t row);
+
+  // CACHED ARCHETYPE GRAPH EDGES
+  std::unordered_map<ComponentTypeID, Archetype*> addEdges;
+  std::unordered_map<ComponentTypeID, Archetype*> removeEdges;
+
+ private:
+  ComponentMask mask;
+  std::vector<ComponentTypeID> types;
+
+  // INDEXED BY COMPONENT TYPE ID
+  std::array<uint32_t, MAX_COMPONENT_TYPES> columnOffsets{};
+  std::array<const ComponentInfo*, MAX_COMPONENT_TYPES> infos{};
+
+  uint32_t chunkCapacity = 0;
+  std::vector<ArchetypeChunk> chunks;
+};
+
+/**
+ * Iterates every entity that owns all of the components Ts, archetype by
+ * archetype and chunk by chunk. Within a chunk the components are walked
+ * linearly with no per-entity lookups. Mirrors the interface of View.
+ */
+template <typename... Ts>
+class ArchetypeView {
+ public:
+  class Iterator {
+   public:
+    Iterator(const ArchetypeView* view, size_t archetype)
+        : view(view), archetype(archetype) {
+      skipEmpty();
+    }
+
+    std::tuple<Entity, Ts&...> operator*() const {
+      Archetype* current = view->archetypes[archetype];
+      const ArchetypeChunk& block = current->getChunks()[chunk];
+      return {current->getEntities(block)[row],
+              current->template getColumn<Ts>(block)[row]...};
+    }
+
+    Iterator& operator++() {
+      row++;
+      skipEmpty();
+      return *this;
+    }
+
+    bool operator!=(const Iterator& other) const {
+      return archetype != other.archetype || chunk != other.chunk ||
+             row != other.row;
+    }
+
+   private:
+    void skipEmpty() {
+      while (archetype < view->archetypes.size()) {
+        auto& chunks = view->archetypes[archetype]->getChunks();
+
+        if (chunk < chunks.size() && row < chunks[chunk].count) return;
+
+        if (chunk < chunks.size()) {
+          chunk++;
+          row = 0;
+        } else {
+          archetype++;
+          chunk = 0;
+          row = 0;
+        }
+      }
+    }
+
+    const ArchetypeView* view;
+    size_t archetype;
+    size_t chunk = 0;
+    uint32_t row = 0;
+  };
+
+  explicit ArchetypeView(std::vector<Archetype*> archetypes)
+      : archetypes(std::move(archetypes)) {
+    for (Archetype* archetype : this->archetypes)
+      for (size_t chunk = 0; chunk < archetype->getChunks().size(); chunk++)
+        blocks.push_back({archetype, chunk});
+  }
+
+  Iterator begin() const { return Iterator(this, 0); }
+  Iterator end() const { return Iterator(this, archetypes.size()); }
+
+  /**
+   * Calls func(entity, components...) for every matching entity.
+   */
+  template <typename Func>
+  void each(Func&& func) const {
+    for (Archetype* archetype : archetypes) {
+      for (const ArchetypeChunk& chunk : archetype->getChunks()) {
+        Entity* entities = archetype->getEntities(chunk);
+        std::tuple<Ts*...> columns{archetype->template getColumn<Ts>(chunk)...};
+
+        for (uint32_t row = 0; row < chunk.count; row++)
+          func(entities[row], std::get<Ts*>(columns)[row]...);
+      }
+    }
+  }
+
+  ////////////////////////////////////
+  // PARTITIONING FOR PARALLEL WORK //
+  ////////////////////////////////////
+
+  // ONE BLOCK PER CHUNK
+  size_t getBlockCount() const { return blocks.size(); }
+
+  template <typename Func>
+  void eachInBlock(size_t block, Func&& func) const {
+    Archetype* archetype = blocks[block].first;
+    const ArchetypeChunk& chunk = archetype->getChunks()[blocks[block].second];
+
+    Entity* entities = archetype->getEntities(chunk);
+    std::tuple<Ts*...> columns{archetype->template getColumn<Ts>(chunk)...};
+
+    for (uint32_t row = 0; row < chunk.count; row++)
+      func(entities[row], std::get<Ts*>(columns)[row]...);
+  }
+
+ private:
+  std::vector<Archetype*> archetypes;
+  std::vector<std::pair<Archetype*, size_t>> blocks;
+};
+
+/**
+ * Archetype backend of the ComponentManager (enabled with
+ * NEU_ECS_ARCHETYPES). Entities with the same component set share an
+ * archetype whose components are stored in fixed-size SoA chunks.
+ *
+ * Note: adding or removing a component moves the entity to another
+ * archetype and may move one other entity within its old archetype, so any
+ * structural change invalidates component references.
+ */
+class ArchetypeStorage {
+ public:
+  ArchetypeStorage() = default;
+  ~ArchetypeStorage();
+
+  ArchetypeStorage(const ArchetypeStorage&) = delete;
+  ArchetypeStorage& operator=(const ArchetypeStorage&) = delete;
+
+  void createEntity(Entity entity);
+  void destroyEntity(Entity entity);
+
+  template <typename T, typename... Args>
+  T& addComponent(Entity entity, Args&&... args) {
+    const ComponentTypeID typeID = registerComponent<T>();
+
+    // REPLACE EXISTING COMPONENT
+    if (hasComponent(entity, typeID)) {
+      T& component = *getComponent<T>(entity);
+      component = T(std::forward<Args>(args)...);
+      return component;
+    }
+
+    EntityLocation& location = moveEntity(entity, typeID, true);
+    void* component =
+        location.archetype->getComponent(location.chunk, location.row, typeID);
+    return *new (component) T(std::forward<Args>(args)...);
+  }
+
+  template <typename T>
+  void removeComponent(Entity entity) {
+    const ComponentTypeID typeID = registerComponent<T>();
+    if (!hasComponent(entity, typeID)) return;
+
+    moveEntity(entity, typeID, false);
+  }
+
+  template <typename T>
+  T* getComponent(Entity entity) {
+    const ComponentTypeID typeID = componentTypeID<T>;
+    if (!hasComponent(entity, typeID)) return nullptr;
+
+    const EntityLocation& location = locations[entity];
+    return static_cast<T*>(location.archetype->getComponent(
+        location.chunk, location.row, typeID));
+  }
+
+  template <typename T>
+  bool hasComponent(Entity entity) const {
+    return hasComponent(entity, componentTypeID<T>);
+  }
+
+  template <typename... Ts>
+  ArchetypeView<Ts...> view() {
+    ComponentMask query;
+    (query.set(componentTypeID<Ts>), ...);
+
+    std::vector<Archetype*> matches;
+    for (Archetype* archetype : archetypeList)
+      if ((archetype->getMask() & query) == query) matches.push_back(archetype);
+
+    return ArchetypeView<Ts...>(std::move(matches));
+  }
+
+ private:
+  struct EntityLocation {
+    Archetype* archetype = nullptr;
+    uint32_t chunk = 0;
+    uint32_t row = 0;
+  };
+
+  template <typename T>
+  ComponentTypeID registerComponent() {
+    const ComponentTypeID typeID = componentTypeID<T>;
+    assert(typeID < MAX_COMPONENT_TYPES);
+
+    if (!infos[typeID]) infos[typeID] = getComponentInfo<T>();
+    return typeID;
+  }
+
+  bool hasComponent(Entity entity, ComponentTypeID typeID) const {
+    return entity < locations.size() && locations[entity].archetype &&
+           locations[entity].archetype->getMask().test(typeID);
+  }
+
+  Archetype* getArchetype(const ComponentMask& mask);
+
+  /**
+   * Moves the entity to the archetype with the component added (or removed)
+   * and returns its new location. An added component is left unconstructed,
+   * a removed one is destroyed.
+   */
+  EntityLocation& moveEntity(Entity entity, ComponentTypeID typeID, bool add);
+
+  void removeFromArchetype(const EntityLocation& location);
+
+  std::vector<EntityLocation> locations;
+
+  std::unordered_map<ComponentMask, std::unique_ptr<Archetype>> archetypes;
+  std::vector<Archetype*> archetypeList;
+
+  std::vector<const ComponentInfo*> infos =
+      std::vector<const ComponentInfo*>(MAX_COMPONENT_TYPES, nullptr);
+};
+
+}  // namespace Neu
@@ -1,50 +1,312 @@
 #pragma once
 
-#include <typeindex>
-#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <utility>
 #include <vector>
 
-#include "scene/game_object.h"  // WHY IS IT STILL IN SCENE
+#include "components/component_type.h"
 
-using Entity = uint32_t;
+#ifdef NEU_ECS_ARCHETYPES
+#include "components/archetype_storage.h"
+#endif
 
 namespace Neu {
+
+// NUMBER OF CANDIDATE ENTITIES PER BLOCK WHEN A VIEW IS SPLIT ACROSS THREADS
+#define VIEW_BLOCK_SIZE 1024
+
 struct IComponentStorage {
   virtual ~IComponentStorage() = default;
+
+  virtual void removeComponent(Entity entity) = 0;
+  virtual bool hasComponent(Entity entity) const = 0;
+  virtual size_t size() const = 0;
 };
 
+/**
+ * Sparse set of components of a single type. Components are kept packed in a
+ * contiguous array so systems can iterate them linearly; the sparse array maps
+ * an entity to its slot in the packed array.
+ *
+ * Note: references into the storage are invalidated when a component of the
+ * same type is added or removed.
+ */
 template <typename T>
 class ComponentStorage : public IComponentStorage {
  public:
-  void addComponent(Entity entity, const T& component);
-  void removeComponent(Entity entity);
-  T* getComponent(Entity entity);
+  template <typename... Args>
+  T& addComponent(Entity entity, Args&&... args) {
+    // REPLACE EXISTING COMPONENT, LIKE THE ARCHETYPE BACKEND
+    if (hasComponent(entity)) {
+      T& component = components[sparse[entity]];
+      component = T(std::forward<Args>(args)...);
+      return component;
+    }
+
+    if (entity >= sparse.size()) sparse.resize(entity + 1, INVALID_INDEX);
+
+    sparse[entity] = static_cast<uint32_t>(components.size());
+    entities.push_back(entity);
+    return components.emplace_back(std::forward<Args>(args)...);
+  }
+
+  void removeComponent(Entity entity) override {
+    if (!hasComponent(entity)) return;
+
+    // INDEX TO BE REMOVED
+    uint32_t index = sparse[entity];
+
+    // SWAP WITH LAST COMPONENT AND RE-MAP
+    uint32_t lastIndex = static_cast<uint32_t>(components.size() - 1);
+    if (index != lastIndex) {
+      Entity lastEntity = entities[lastIndex];
+      components[index] = std::move(components[lastIndex]);
+      entities[index] = lastEntity;
+      sparse[lastEntity] = index;
+    }
+
+    components.pop_back();
+    entities.pop_back();
+    sparse[entity] = INVALID_INDEX;
+  }
+
+  bool hasComponent(Entity entity) const override {
+    return entity < sparse.size() && sparse[entity] != INVALID_INDEX;
+  }
+
+  T* getComponent(Entity entity) {
+    if (!hasComponent(entity)) return nullptr;
+    return &components[sparse[entity]];
+  }
+
+  // UNCHECKED, ENTITY MUST HAVE THE COMPONENT
+  T& get(Entity entity) { return components[sparse[entity]]; }
+
+  size_t size() const override { return components.size(); }
+
+  ///////////////////
+  // PACKED ACCESS //
+  ///////////////////
+
+  T& getComponentAt(size_t index) { return components[index]; }
+  Entity getEntityAt(size_t index) const { return entities[index]; }
+
+  const std::vector<Entity>& getEntities() const { return entities; }
+
+  typename std::vector<T>::iterator begin() { return components.begin(); }
+  typename std::vector<T>::iterator end() { return components.end(); }
 
  private:
+  static constexpr uint32_t INVALID_INDEX =
+      std::numeric_limits<uint32_t>::max();
+
   std::vector<T> components;
-  std::unordered_map<Entity, uint32_t> entityToIndex;
-  std::unordered_map<uint32_t, Entity> indexToEntity;
+  std::vector<Entity> entities;   // PACKED INDEX -> ENTITY
+  std::vector<uint32_t> sparse;   // ENTITY -> PACKED INDEX
+};
+
+/**
+ * Iterates every entity that owns all of the components Ts. Only the smallest
+ * of the pools is walked, so the cost scales with the number of candidate
+ * entities rather than the number of entities in the scene.
+ *
+ * Each element is a tuple of the entity and references to its components:
+ *
+ *   for (auto [entity, transform, mesh] :
+ *        componentManager.view<TransformComponent, MeshComponent>()) { ... }
+ *
+ * Note: adding or removing components of the viewed types while iterating
+ * invalidates the view.
+ */
+template <typename... Ts>
+class View {
+ public:
+  class Iterator {
+   public:
+    Iterator(const View* view, size_t index) : view(view), index(index) {
+      skipUnmatched();
+    }
+
+    std::tuple<Entity, Ts&...> operator*() const {
+      Entity entity = (*view->entities)[index];
+      return {entity, std::get<ComponentStorage<Ts>*>(view->storages)
+                          ->get(entity)...};
+    }
+
+    Iterator& operator++() {
+      index++;
+      skipUnmatched();
+      return *this;
+    }
+
+    bool operator!=(const Iterator& other) const {
+      return index != other.index;
+    }
+
+   private:
+    void skipUnmatched() {
+      while (index < view->entities->size() &&
+             !view->contains((*view->entities)[index]))
+        index++;
+    }
+
+    const View* view;
+    size_t index;
+  };
+
+  explicit View(ComponentStorage<Ts>&... pools) : storages(&pools...) {
+    // EVERY MATCH IS IN THE SMALLEST POOL, SO ONLY THAT ONE IS WALKED
+    ((entities = (!entities || pools.size() < entities->size())
+                     ? &pools.getEntities()
+                     : entities),
+     ...);
+  }
+
+  bool contains(Entity entity) const {
+    return (std::get<ComponentStorage<Ts>*>(storages)->hasComponent(entity) &&
+            ...);
+  }
+
+  Iterator begin() const { return Iterator(this, 0); }
+  Iterator end() const { return Iterator(this, entities->size()); }
+
+  /**
+   * Calls func(entity, components...) for every matching entity.
+   */
+  template <typename Func>
+  void each(Func&& func) const {
+    for (Entity entity : *entities)
+      if (contains(entity))
+        func(entity, std::get<ComponentStorage<Ts>*>(storages)->get(entity)...);
+  }
+
+  ////////////////////////////////////
+  // PARTITIONING FOR PARALLEL WORK //
+  ////////////////////////////////////
+
+  size_t getBlockCount() const {
+    return (entities->size() + VIEW_BLOCK_SIZE - 1) / VIEW_BLOCK_SIZE;
+  }
+
+  /**
+   * Calls func(entity, components...) for every matching entity in the block.
+   * Different blocks never share an entity, so they can run concurrently.
+   */
+  template <typename Func>
+  void eachInBlock(size_t block, Func&& func) const {
+    const size_t begin = block * VIEW_BLOCK_SIZE;
+    const size_t end = std::min(begin + VIEW_BLOCK_SIZE, entities->size());
+
+    for (size_t index = begin; index < end; index++) {
+      Entity entity = (*entities)[index];
+      if (contains(entity))
+        func(entity, std::get<ComponentStorage<Ts>*>(storages)->get(entity)...);
+    }
+  }
+
+ private:
+  std::tuple<ComponentStorage<Ts>*...> storages;
+  const std::vector<Entity>* entities = nullptr;
 };
 
+/**
+ * Owns every entity's components. By default components are stored in one
+ * sparse-set pool per type; building with NEU_ECS_ARCHETYPES switches to the
+ * archetype/chunk backend in archetype_storage.h. Both expose the same API.
+ */
 class ComponentManager {
  public:
+  Entity createEntity();
+  void destroyEntity(Entity entity);
+
+  /**
+   * Adds a T to the entity, or replaces the one it already has.
+   */
+  template <typename T, typename... Args>
+  T& addComponent(Entity entity, Args&&... args) {
+#ifdef NEU_ECS_ARCHETYPES
+    return archetypes.addComponent<T>(entity, std::forward<Args>(args)...);
+#else
+    return getComponentStorage<T>().addComponent(entity,
+                                                 std::forward<Args>(args)...);
+#endif
+  }
+
   template <typename T>
-  void registerComponent();
+  void removeComponent(Entity entity) {
+#ifdef NEU_ECS_ARCHETYPES
+    archetypes.removeComponent<T>(entity);
+#else
+    getComponentStorage<T>().removeComponent(entity);
+#endif
+  }
 
+  /**
+   * Returns the component of type T owned by the entity, or nullptr if the
+   * entity does not have one.
+   */
   template <typename T>
-  void addComponent(Entity entity, const T& component);
+  T* getComponent(Entity entity) {
+#ifdef NEU_ECS_ARCHETYPES
+    return archetypes.getComponent<T>(entity);
+#else
+    return getComponentStorage<T>().getComponent(entity);
+#endif
+  }
 
   template <typename T>
-  void removeComponent(Entity entity, const T& component);
+  bool hasComponent(Entity entity) {
+#ifdef NEU_ECS_ARCHETYPES
+    return archetypes.hasComponent<T>(entity);
+#else
+    return getComponentStorage<T>().hasComponent(entity);
+#endif
+  }
+
+#ifdef NEU_ECS_ARCHETYPES
+  /**
+   * Returns a view over the entities that own all of the components Ts.
+   */
+  template <typename... Ts>
+  ArchetypeView<Ts...> view() {
+    return archetypes.view<Ts...>();
+  }
+#else
+  /**
+   * Returns a view over the entities that own all of the components Ts.
+   */
+  template <typename... Ts>
+  View<Ts...> view() {
+    return View<Ts...>(getComponentStorage<Ts>()...);
+  }
 
+  /**
+   * Returns the packed pool of components of type T, creating it on first use.
+   */
   template <typename T>
-  void getComponent(Entity entity, const T& component);
+  ComponentStorage<T>& getComponentStorage() {
+    const ComponentTypeID typeID = componentTypeID<T>;
+
+    if (typeID >= storages.size()) storages.resize(typeID + 1);
+    if (!storages[typeID])
+      storages[typeID] = std::make_unique<ComponentStorage<T>>();
+
+    return *static_cast<ComponentStorage<T>*>(storages[typeID].get());
+  }
+#endif
 
  private:
-  template <typename T>
-  ComponentStorage<T>* getComponentStorage();
+  Entity nextEntity = 0;
 
-  std::unordered_map<std::type_index, std::unique_ptr<IComponentStorage>>
-      components;
+#ifdef NEU_ECS_ARCHETYPES
+  ArchetypeStorage archetypes;
+#else
+  // INDEXED BY COMPONENT TYPE ID
+  std::vector<std::unique_ptr<IComponentStorage>> storages;
+#endif
 };
-}  // namespace Neu
\ No newline at end of file
+}  // namespace Neu
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <bitset>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+
+using Entity = uint32_t;
+
+namespace Neu {
+
+static constexpr Entity NULL_ENTITY = std::numeric_limits<Entity>::max();
+
+// UPPER BOUND ON DISTINCT COMPONENT TYPES (SIZE OF AN ARCHETYPE SIGNATURE)
+#define MAX_COMPONENT_TYPES 64
+
+using ComponentTypeID = uint32_t;
+using ComponentMask = std::bitset<MAX_COMPONENT_TYPES>;
+
+/**
+ * Hands out dense, per-type component IDs. Each component type receives its
+ * ID once during static initialization, so looking up a component pool is a
+ * constant load and a vector index instead of hashing typeid(T).name().
+ *
+ * The IDs are not compile-time constants: they index the component masks, so
+ * they must be dense, and any translation unit (games, benchmarks) can add
+ * component types. Their order depends on initialization order and may
+ * differ between builds, so they must never be stored.
+ */
+class ComponentType {
+ public:
+  static ComponentTypeID next() {
+    // THE MASKS WOULD SILENTLY DROP THE BITS OF FURTHER TYPES
+    assert(count < MAX_COMPONENT_TYPES && "Too many component types");
+    return count++;
+  }
+  static ComponentTypeID getCount() { return count; }
+
+ private:
+  static inline ComponentTypeID count = 0;
+};
+
+template <typename T>
+inline const ComponentTypeID componentTypeID = ComponentType::next();
+
+}  // namespace Neu
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "math/Vector.h"
+
+namespace Neu {
+
+/**
+ * Point light at the position of the entity's TransformComponent. Its
+ * influence ends at radius, which bounds the clusters it is assigned to.
+ */
+class LightComponent {
+ public:
+  Vector3f color{1.0f, 1.0f, 1.0f};
+  float intensity = 1.0f;
+  float radius = 10.0f;
+};
+
+/**
+ * Light from infinitely far away (the sun), independent of the entity's
+ * transform. If castsShadows is set, the renderer draws cascaded shadow maps
+ * for it. Only the first directional light of a scene is used.
+ */
+class DirectionalLightComponent {
+ public:
+  // THE WAY THE LIGHT TRAVELS (FROM THE LIGHT TO THE SCENE), NORMALIZED
+  Vector3f direction{0.0f, -1.0f, 0.0f};
+
+  Vector3f color{1.0f, 1.0f, 1.0f};
+  float intensity = 1.0f;
+
+  bool castsShadows = true;
+};
+
+}  // namespace Neu
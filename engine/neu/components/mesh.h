@@ -1,53 +1,119 @@
 #pragma once
 
-#include <bitset>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "math/Vector.h"
+#include "utility/bounds.h"
 
 namespace Neu {
 
+class MeshArena;
+class DynamicMeshBuffer;
+
+/**
+ * Location of a mesh's geometry in its buffers, as passed to the draw call.
+ * Render snapshots keep a copy, since a dynamic mesh can be updated for the
+ * next frame while the last one is drawn.
+ */
+struct MeshDrawRange {
+  uint32_t baseVertex = 0;
+  uint32_t firstIndex = 0;
+  uint32_t indexCount = 0;
+};
+
+/**
+ * Handle to static geometry stored in the MeshArena. Meshes do not own GL
+ * objects: all meshes with the same vertex format share the arena's buffers
+ * and VAO and are drawn with their base vertex and first index. Created
+ * through MeshArena::createMesh and shared between entities through
+ * MeshComponent; the storage is returned to the arena when the last
+ * reference goes away.
+ *
+ * Dynamic meshes (MeshArena::createDynamicMesh) instead own a streaming
+ * DynamicMeshBuffer and can be rewritten with update() every frame.
+ */
+class Mesh {
+ public:
+  ~Mesh();
+
+  Mesh(const Mesh&) = delete;
+  Mesh& operator=(const Mesh&) = delete;
+
+  /**
+   * Replaces the geometry of a dynamic mesh. The attributes must match the
+   * ones the mesh was created with. Returns false for static meshes or if
+   * the geometry exceeds the capacity.
+   *
+   * Does not call GL, so systems can update meshes on the simulation
+   * thread: the location and bounds change right away, the geometry is
+   * staged and reaches the GPU with MeshArena::uploadDynamicMeshes on the GL
+   * thread, before the snapshot extracted after the update is drawn.
+   */
+  bool update(const std::vector<Vector3f>& positions,
+              const std::vector<Vector3f>& normals,
+              const std::vector<Vector3f>& colors,
+              const std::vector<Vector3i>& faces);
+
+  inline bool isDynamic() const { return dynamicBuffer != nullptr; }
+
+  // SHARED BY EVERY STATIC MESH OF THE SAME VERTEX FORMAT
+  unsigned int getVAO() const;
+
+  // UNIQUE PER MESH, USED IN SORT KEYS
+  inline uint32_t getID() const { return id; }
+
+  inline uint32_t getVertexFormat() const { return format; }
+  inline unsigned int getFaceCount() const { return indexCount / 3; }
+
+  ///////////////////////////
+  // LOCATION IN THE ARENA //
+  ///////////////////////////
+
+  inline uint32_t getBaseVertex() const { return baseVertex; }
+  inline uint32_t getVertexCount() const { return vertexCount; }
+  inline uint32_t getFirstIndex() const { return firstIndex; }
+  inline uint32_t getIndexCount() const { return indexCount; }
+
+  inline MeshDrawRange getDrawRange() const {
+    return {baseVertex, firstIndex, indexCount};
+  }
+
+  // LOCAL SPACE BOUNDS, COMPUTED ON CREATION AND ON EVERY UPDATE
+  inline const AABB& getBounds() const { return bounds; }
+
+ private:
+  friend class MeshArena;
+
+  Mesh() = default;
+
+  MeshArena* arena = nullptr;
+
+  uint32_t id = 0;
+  uint32_t format = 0;
+  uint64_t hash = 0;
+
+  uint32_t baseVertex = 0;
+  uint32_t vertexCount = 0;
+  uint32_t firstIndex = 0;
+  uint32_t indexCount = 0;
+
+  AABB bounds;
+
+  std::unique_ptr<DynamicMeshBuffer> dynamicBuffer;
+};
+
+/**
+ * Draws a (possibly shared) mesh at the entity's transform. Entities that
+ * share a mesh are drawn together in one instanced draw call.
+ */
 class MeshComponent {
  public:
-  MeshComponent();
-  ~MeshComponent();
-
-  // THESE FUNCTIONS CAN BE MADE STATIC, I.E.
-  // static void setupVertices(MeshComponent mesh, std::vector<Vector3f>&
-  // vertices);
-  void setupVertices(std::vector<Vector3f>& vertices);
-  void setupNormals(std::vector<Vector3f>& normals);
-  void setupColors(std::vector<Vector3f>& colors);
-  void setupFaces(std::vector<Vector3i>& faces);
-
-  void updateVertices(std::vector<Vector3f>& vertices);
-  void updateNormals(std::vector<Vector3f>& normals);
-  void updateColors(std::vector<Vector3f>& colors);
-  void updateFaces(std::vector<Vector3i>& faces);
-
-  inline unsigned int getVAO() { return VAO; };
-  inline unsigned int getFaceCount() { return faceCount; }
-
- protected:
-  enum SetupFlags {
-    SETUP_VERTICES,
-    SETUP_NORMALS,
-    SETUP_COLORS,
-    SETUP_FACES,
-    SETUP_VAO,
-    SETUP_COUNT  // KEEP AS LAST ITEM
-  };
-
-  std::bitset<SETUP_COUNT> setup;
-
-  unsigned int faceCount;
-  unsigned int VAO;
-
-  unsigned int positionVBO;
-  unsigned int normalVBO;
-  unsigned int colorVBO;
-
-  unsigned int EBO;
+  std::shared_ptr<Mesh> mesh;
+
+  // DEBUG
+  Vector3f color;
 };
 
 }  // namespace Neu
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Jolt/Jolt.h>
+#include <Jolt/Math/Quat.h>
 #include <Jolt/Physics/Body/BodyID.h>
 
 #include "math/Vector.h"
@@ -24,6 +25,16 @@ class RigidBodyComponent {
 
   Vector3f linearVelocity;
 
+  // BODY STATE AFTER THE LAST TWO FIXED STEPS, THE TRANSFORM IS INTERPOLATED
+  // BETWEEN THEM FOR RENDERING
+  Vector3f previousPosition;
+  Vector3f currentPosition;
+  Quat previousRotation = Quat::sIdentity();
+  Quat currentRotation = Quat::sIdentity();
+
+  // CLEARED ONCE BOTH STATES ARE EQUAL AND HAVE BEEN WRITTEN TO THE TRANSFORM
+  bool interpolating = true;
+
  protected:
   BodyID ID;
 };
@@ -1,24 +1,33 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
+#include "components/component_type.h"
 #include "math/Matrix.h"
 #include "math/Vector.h"
 
-class GameObject;
-
 namespace Neu {
 
 class TransformComponent {
  public:
-  GameObject* parent;
-  std::vector<GameObject*> children;
+  // CHANGE THROUGH TransformSystem::setParent TO KEEP BOTH SIDES IN SYNC
+  Entity parent = NULL_ENTITY;
+  std::vector<Entity> children;
 
+  // RELATIVE TO THE PARENT
   Vector3f position{0.0f, 0.0f, 0.0f};
   Vector3f rotation{0.0f, 0.0f, 0.0f};
   Vector3f scale{1.0f, 1.0f, 1.0f};
 
-  Matrix4x4f transform;
+  // SET AFTER CHANGING POSITION, ROTATION OR SCALE
+  bool dirty = true;
+
+  Matrix4x4f localTransform;
+  Matrix4x4f transform;  // WORLD
+
+  // LAST FRAME THE WORLD MATRIX CHANGED (USED FOR PROPAGATION)
+  uint32_t updatedFrame = 0;
 };
 
-}  // namespace Neu
\ No newline at end of file
+}  // namespace Neu
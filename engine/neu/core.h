@@ -18,7 +18,10 @@ struct LightData {
   Vector4f light_color;
 };
 
+// MATCHES THE STD140 LAYOUT OF THE LIGHT BLOCK IN light.frag. THE COUNT COMES
+// FIRST SO SHADER VARIANTS WITH FEWER LIGHTS CAN READ A PREFIX
 struct LightBuffer {
-  LightData lights[MAX_LIGHTS];
   int num_lights;
+  int padding[3];
+  LightData lights[MAX_LIGHTS];
 };
\ No newline at end of file
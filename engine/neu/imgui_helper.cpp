@@ -5,6 +5,8 @@
 #include "application.h"
 #include "components/rigid_body.h"
 #include "components/transform.h"
+#include "render/mesh_arena.h"
+#include "render/renderer.h"
 #include "scene/camera.h"
 #include "scene/game_object.h"
 #include "scene/scene.h"
@@ -120,6 +122,44 @@ void ImGuiHelper::showFramerateWidget() {
   ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
   ImGui::Text("Clock: %.2f", Application::getInstance()->getWallTime());
 
+  const Scene* scene = Application::getInstance()->getWorld();
+  ImGui::Text("Fixed steps: %d (alpha %.2f)", scene->getFixedSteps(),
+              scene->getInterpolationAlpha());
+
+  /////////////////////
+  // RENDER COUNTERS //
+  /////////////////////
+
+  const RenderStatistics& renderStatistics =
+      Application::getInstance()->getRenderer()->getStatistics();
+
+  ImGui::Separator();
+  ImGui::Text("Visible: %u", renderStatistics.visibleObjects);
+  ImGui::Text("Culled: %u", renderStatistics.culledObjects);
+  ImGui::Text("Draw packets: %u", renderStatistics.packets);
+  ImGui::Text("Draw calls: %u", renderStatistics.drawCalls);
+  ImGui::Text("Shader changes: %u", renderStatistics.shaderChanges);
+  ImGui::Text("VAO changes: %u", renderStatistics.vertexArrayChanges);
+  ImGui::Text("Command buffers: %u (%u commands)",
+              renderStatistics.commandBuffers, renderStatistics.commands);
+
+  ImGui::Separator();
+  ImGui::Text("Lights: %u", renderStatistics.lights);
+  ImGui::Text("Cluster light indices: %u",
+              renderStatistics.clusterLightIndices);
+  ImGui::Text("Shadow passes: %u", renderStatistics.shadowPasses);
+  ImGui::Text("Shadow cache updates: %u",
+              renderStatistics.shadowCacheUpdates);
+
+  MeshArena* meshArena = Application::getInstance()->getMeshArena();
+
+  ImGui::Separator();
+  ImGui::Text("Meshes: %zu", meshArena->getMeshCount());
+  ImGui::Text("Arena vertices: %zu", meshArena->getVertexCount());
+  ImGui::Text("Arena indices: %zu", meshArena->getIndexCount());
+  ImGui::Text("Arena vertex memory: %.1f KB",
+              meshArena->getVertexBytes() / 1024.0f);
+
   ImGui::End();
 }
 
@@ -377,14 +417,13 @@ void ImGuiHelper::showEntityEditorWindow() {
 };
 
 static void buildProfilerTree(int sectionID,
-                              std::vector<Neu::ProfilerSection*>& section) {
-  for (int childSectionID : section[sectionID]->children) {
+                              const Neu::ProfilerThread& thread) {
+  for (int childSectionID : thread.profilerData[sectionID]->children) {
     ImGui::Indent();
-    ImGui::Text(
-        "%s: %.3f ms", section[childSectionID]->name.c_str(),
-        Neu::Profiler::getInstance().getTimeForSection(childSectionID).count() *
-            1000);
-    buildProfilerTree(childSectionID, section);
+    ImGui::Text("%s: %.3f ms",
+                thread.profilerData[childSectionID]->name.c_str(),
+                thread.getTimeForSection(childSectionID).count() * 1000);
+    buildProfilerTree(childSectionID, thread);
     ImGui::Unindent();
   }
 }
@@ -399,15 +438,67 @@ void ImGuiHelper::showProfilerWindow() {
     return;
   }
 
-  std::vector<Neu::ProfilerSection*> profilerData =
-      Profiler::getInstance().getProfilerData();
+  const std::vector<std::unique_ptr<Neu::ProfilerThread>>& threads =
+      Profiler::getInstance().getThreads();
+
+  bool hasData = false;
+
+  for (const std::unique_ptr<Neu::ProfilerThread>& thread : threads) {
+    if (thread->profilerData.empty()) continue;
+
+    if (hasData) ImGui::Separator();
+    ImGui::Text("%s", thread->name.c_str());
+
+    for (const Neu::ProfilerSection* section : thread->profilerData) {
+      if (section->parentSection >= 0) continue;
+
+      ImGui::Text("%s: %.3f ms", section->name.c_str(),
+                  thread->getTimeForSection(section->ID).count() * 1000);
+      buildProfilerTree(section->ID, *thread);
+    }
+
+    hasData = true;
+  }
+
+  if (!hasData) ImGui::Text("No profiler data available");
+
+  //////////////////
+  // GPU SECTIONS //
+  //////////////////
+
+  const std::vector<GPUProfilerSection>& gpuSections =
+      GPUProfiler::getInstance().getResults();
+
+  if (!gpuSections.empty()) {
+    ImGui::Separator();
+    ImGui::Text("GPU");
+
+    for (const GPUProfilerSection& section : gpuSections) {
+      for (int i = 0; i < section.depth; i++) ImGui::Indent();
+
+      ImGui::Text("%s: %.3f ms", section.name, section.milliseconds);
+
+      for (int i = 0; i < section.depth; i++) ImGui::Unindent();
+    }
+  }
+
+  ////////////////////////
+  // WORKER UTILIZATION //
+  ////////////////////////
+
+  const std::vector<float>& workerUtilization =
+      Profiler::getInstance().getWorkerUtilization();
 
-  if (profilerData.size() == 0) {
-    ImGui::Text("No profiler data available");
-  } else {
-    ImGui::Text("%s: %.3f ms", profilerData[0]->name.c_str(),
-                Profiler::getInstance().getTimeForSection(0).count() * 1000);
-    buildProfilerTree(0, profilerData);
+  if (!workerUtilization.empty()) {
+    ImGui::Separator();
+    ImGui::Text("Workers");
+
+    for (size_t i = 0; i < workerUtilization.size(); i++) {
+      char label[32];
+      snprintf(label, sizeof(label), "%zu: %.0f%%", i,
+               workerUtilization[i] * 100.0f);
+      ImGui::ProgressBar(workerUtilization[i], ImVec2(-1.0f, 0.0f), label);
+    }
   }
 
   ImGui::End();
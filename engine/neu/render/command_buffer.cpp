@@ -0,0 +1,46 @@
+#include "command_buffer.h"
+
+using namespace Neu;
+
+void RenderCommandBuffer::clear()
+{
+	commands.clear();
+	matrices.clear();
+}
+
+void RenderCommandBuffer::bindShader(Shader* shader)
+{
+	RenderCommand command;
+	command.type = RenderCommandType::BIND_SHADER;
+	command.shader = shader;
+
+	commands.push_back(command);
+}
+
+void RenderCommandBuffer::bindGeometry(Mesh* mesh)
+{
+	RenderCommand command;
+	command.type = RenderCommandType::BIND_GEOMETRY;
+	command.mesh = mesh;
+
+	commands.push_back(command);
+}
+
+void RenderCommandBuffer::setUniform(HashedName name, const Matrix4x4f& value)
+{
+	RenderCommand command;
+	command.type = RenderCommandType::SET_UNIFORM_MATRIX;
+	command.uniformMatrix = { name.hash, (uint32_t)matrices.size() };
+
+	commands.push_back(command);
+	matrices.push_back(value);
+}
+
+void RenderCommandBuffer::drawInstanced(const MeshDrawRange* range, uint32_t firstInstance, uint32_t instanceCount)
+{
+	RenderCommand command;
+	command.type = RenderCommandType::DRAW_INSTANCED;
+	command.draw = { range, firstInstance, instanceCount };
+
+	commands.push_back(command);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "math/Matrix.h"
+#include "utility/hashed_name.h"
+
+namespace Neu
+{
+	class Shader;
+	class Mesh;
+	struct MeshDrawRange;
+
+	enum class RenderCommandType : uint8_t
+	{
+		BIND_SHADER,
+		BIND_GEOMETRY,       // VERTEX AND INDEX SOURCE OF THE MESH
+		SET_UNIFORM_MATRIX,  // ON THE BOUND SHADER
+		DRAW_INSTANCED,
+	};
+
+	/**
+	 * A single recorded command. Commands refer to engine objects (shaders,
+	 * meshes, ranges of the frame's instance data) and never to API
+	 * objects, so recording does not depend on the graphics backend.
+	 */
+	struct RenderCommand
+	{
+		struct UniformMatrix
+		{
+			uint32_t name;    // HashedName::hash
+			uint32_t matrix;  // INDEX INTO THE MATRICES OF THE BUFFER
+		};
+
+		struct Draw
+		{
+			const MeshDrawRange* range;
+			uint32_t firstInstance;
+			uint32_t instanceCount;
+		};
+
+		RenderCommandType type;
+
+		union
+		{
+			Shader* shader;
+			Mesh* mesh;
+			UniformMatrix uniformMatrix;
+			Draw draw;
+		};
+	};
+
+	/**
+	 * Linear list of render commands. Any thread can record into its own
+	 * buffer; the buffers are then replayed in order on the GL thread (see
+	 * Renderer::executeCommands), which also skips binds that do not change
+	 * anything, including across buffer boundaries.
+	 *
+	 * Clearing keeps the storage, so buffers reused every frame do not
+	 * allocate once they have grown.
+	 */
+	class RenderCommandBuffer
+	{
+	public:
+		void clear();
+
+		void bindShader(Shader* shader);
+		void bindGeometry(Mesh* mesh);
+		void setUniform(HashedName name, const Matrix4x4f& value);
+		void drawInstanced(const MeshDrawRange* range, uint32_t firstInstance, uint32_t instanceCount);
+
+		const std::vector<RenderCommand>& getCommands() const { return commands; }
+		const Matrix4x4f& getMatrix(uint32_t index) const { return matrices[index]; }
+
+		size_t size() const { return commands.size(); }
+
+	private:
+		std::vector<RenderCommand> commands;
+
+		// UNIFORM VALUES, KEPT OUT OF THE COMMANDS TO KEEP THEM SMALL
+		std::vector<Matrix4x4f> matrices;
+	};
+}
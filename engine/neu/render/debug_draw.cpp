@@ -0,0 +1,186 @@
+#include "debug_draw.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "application.h"
+#include "core.h"
+#include "render/gl_extensions.h"
+#include "shader_manager.h"
+
+using namespace Neu;
+
+DebugDraw::DebugDraw()
+{
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+	persistent = GLExtensions::hasBufferStorage;
+
+	if (persistent)
+	{
+		// MAPPED ONCE FOR THE LIFETIME OF THE BUFFER
+		const GLsizeiptr size = SEGMENT_COUNT * SEGMENT_VERTEX_COUNT * sizeof(Vertex);
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		GLExtensions::bufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+		vertices = (Vertex*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+
+		if (!vertices)
+		{
+			Logger::warn("Failed to map debug draw buffer, falling back to uploads\n");
+			persistent = false;
+
+			// IMMUTABLE STORAGE CANNOT BE RESIZED, START OVER WITH A NEW BUFFER
+			glDeleteBuffers(1, &VBO);
+			glGenBuffers(1, &VBO);
+			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		}
+	}
+
+	if (!persistent)
+	{
+		vertices = new Vertex[SEGMENT_VERTEX_COUNT];
+		glBufferData(GL_ARRAY_BUFFER, SEGMENT_VERTEX_COUNT * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+	}
+
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+	glEnableVertexAttribArray(0);
+
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+	glEnableVertexAttribArray(1);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+DebugDraw::~DebugDraw()
+{
+	for (void* fence : fences)
+		if (fence)
+			glDeleteSync((GLsync)fence);
+
+	if (persistent)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	else
+	{
+		delete[] vertices;
+	}
+
+	glDeleteBuffers(1, &VBO);
+	glDeleteVertexArrays(1, &VAO);
+}
+
+void DebugDraw::addLine(const Vector3f& start, const Vector3f& end, uint32_t color)
+{
+	if (lineVertexCount + 2 > LINE_VERTEX_CAPACITY)
+	{
+		overflowed = true;
+		return;
+	}
+
+	Vertex* line = getSegment() + lineVertexCount;
+	line[0] = { start, color };
+	line[1] = { end, color };
+
+	lineVertexCount += 2;
+}
+
+void DebugDraw::addTriangle(const Vector3f& v1, const Vector3f& v2, const Vector3f& v3, uint32_t color)
+{
+	if (triangleVertexCount + 3 > TRIANGLE_VERTEX_CAPACITY)
+	{
+		overflowed = true;
+		return;
+	}
+
+	// TRIANGLES LIVE AFTER THE LINES IN EVERY SEGMENT
+	Vertex* triangle = getSegment() + LINE_VERTEX_CAPACITY + triangleVertexCount;
+	triangle[0] = { v1, color };
+	triangle[1] = { v2, color };
+	triangle[2] = { v3, color };
+
+	triangleVertexCount += 3;
+}
+
+void DebugDraw::flush()
+{
+	NEU_PROFILE_FUNCTION;
+
+	if (overflowed)
+		Logger::warn("Debug draw buffer full, some primitives were dropped\n");
+
+	if (lineVertexCount > 0 || triangleVertexCount > 0)
+	{
+		glBindVertexArray(VAO);
+
+		if (!persistent)
+		{
+			// ORPHAN, THEN UPLOAD ONLY THE USED PARTS OF THE STAGING MEMORY
+			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+			glBufferData(GL_ARRAY_BUFFER, SEGMENT_VERTEX_COUNT * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, lineVertexCount * sizeof(Vertex), vertices);
+			glBufferSubData(GL_ARRAY_BUFFER, LINE_VERTEX_CAPACITY * sizeof(Vertex), triangleVertexCount * sizeof(Vertex), vertices + LINE_VERTEX_CAPACITY);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+
+		Application::getInstance()->getShaderManager()->getShader("line")->use();
+
+		const GLint first = persistent ? segment * SEGMENT_VERTEX_COUNT : 0;
+
+		if (lineVertexCount > 0)
+			glDrawArrays(GL_LINES, first, lineVertexCount);
+
+		if (triangleVertexCount > 0)
+			glDrawArrays(GL_TRIANGLES, first + LINE_VERTEX_CAPACITY, triangleVertexCount);
+
+		glBindVertexArray(0);
+	}
+
+	lineVertexCount = 0;
+	triangleVertexCount = 0;
+	overflowed = false;
+
+	if (!persistent)
+		return;
+
+	/////////////////////////
+	// ADVANCE RING BUFFER //
+	/////////////////////////
+
+	fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	segment = (segment + 1) % SEGMENT_COUNT;
+
+	// WAIT UNTIL THE GPU IS DONE READING THE SEGMENT WE ARE ABOUT TO FILL
+	if (fences[segment])
+	{
+		GLenum result = glClientWaitSync((GLsync)fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+		while (result == GL_TIMEOUT_EXPIRED)
+			result = glClientWaitSync((GLsync)fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+
+		glDeleteSync((GLsync)fences[segment]);
+		fences[segment] = nullptr;
+	}
+}
+
+uint32_t DebugDraw::packColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+{
+	// BYTE ORDER MATCHES THE GL_UNSIGNED_BYTE ATTRIBUTE ON LITTLE-ENDIAN
+	return (uint32_t)r | ((uint32_t)g << 8) | ((uint32_t)b << 16) | ((uint32_t)a << 24);
+}
+
+uint32_t DebugDraw::packColor(const Vector4f& color)
+{
+	auto toByte = [](float value) { return (uint8_t)(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f); };
+
+	return packColor(toByte(color.x), toByte(color.y), toByte(color.z), toByte(color.w));
+}
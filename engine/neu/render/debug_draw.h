@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+
+#include "math/Vector.h"
+
+namespace Neu
+{
+	/**
+	 * Immediate-mode batcher for debug lines and triangles. Primitives are
+	 * written straight into a ring of vertex buffer segments (persistently
+	 * mapped when GL_ARB_buffer_storage is available, otherwise staged on the
+	 * CPU and uploaded to an orphaned buffer) and drawn by flush() with at
+	 * most one GL_LINES and one GL_TRIANGLES call.
+	 */
+	class DebugDraw
+	{
+	public:
+		struct Vertex
+		{
+			Vector3f position;
+			uint32_t color;  // RGBA8
+		};
+
+		DebugDraw();
+		~DebugDraw();
+
+		DebugDraw(const DebugDraw&) = delete;
+		DebugDraw& operator=(const DebugDraw&) = delete;
+
+		void addLine(const Vector3f& start, const Vector3f& end, uint32_t color);
+		void addTriangle(const Vector3f& v1, const Vector3f& v2, const Vector3f& v3, uint32_t color);
+
+		/**
+		 * Draws everything added since the last flush and moves on to the next
+		 * buffer segment.
+		 */
+		void flush();
+
+		static uint32_t packColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a);
+		static uint32_t packColor(const Vector4f& color);
+
+	private:
+		// SEGMENTS IN FLIGHT, SO THE CPU NEVER WRITES WHAT THE GPU IS READING
+		static constexpr int SEGMENT_COUNT = 3;
+
+		// VERTICES PER SEGMENT FOR EACH PRIMITIVE TYPE
+		static constexpr uint32_t LINE_VERTEX_CAPACITY = 64 * 1024;
+		static constexpr uint32_t TRIANGLE_VERTEX_CAPACITY = 48 * 1024;
+		static constexpr uint32_t SEGMENT_VERTEX_COUNT = LINE_VERTEX_CAPACITY + TRIANGLE_VERTEX_CAPACITY;
+
+		Vertex* getSegment() const { return vertices + (persistent ? segment * SEGMENT_VERTEX_COUNT : 0); }
+
+		unsigned int VAO;
+		unsigned int VBO;
+
+		bool persistent;
+
+		// MAPPED BUFFER (PERSISTENT) OR CPU STAGING MEMORY (FALLBACK)
+		Vertex* vertices;
+
+		int segment = 0;
+		void* fences[SEGMENT_COUNT] = {};
+
+		uint32_t lineVertexCount = 0;
+		uint32_t triangleVertexCount = 0;
+		bool overflowed = false;
+	};
+}
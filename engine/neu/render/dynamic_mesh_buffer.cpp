@@ -0,0 +1,178 @@
+#include "dynamic_mesh_buffer.h"
+
+#include <cstring>
+
+#include "core.h"
+#include "render/gl_extensions.h"
+#include "render/vertex_format.h"
+
+using namespace Neu;
+
+DynamicMeshBuffer::DynamicMeshBuffer(uint32_t format, uint32_t maxVertexCount, uint32_t maxIndexCount)
+	: format(format & ~VERTEX_HALF_POSITION), maxVertexCount(maxVertexCount), maxIndexCount(maxIndexCount)
+{
+	stride = VertexLayout::get(this->format).stride;
+
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+	glGenBuffers(1, &EBO);
+
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+	persistent = GLExtensions::hasBufferStorage;
+
+	if (persistent)
+	{
+		// MAPPED ONCE FOR THE LIFETIME OF THE BUFFERS
+		const GLsizeiptr vertexSize = (GLsizeiptr)SEGMENT_COUNT * maxVertexCount * stride;
+		const GLsizeiptr indexSize = (GLsizeiptr)SEGMENT_COUNT * maxIndexCount * sizeof(uint32_t);
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		GLExtensions::bufferStorage(GL_ARRAY_BUFFER, vertexSize, nullptr, flags);
+		GLExtensions::bufferStorage(GL_ELEMENT_ARRAY_BUFFER, indexSize, nullptr, flags);
+
+		vertices = (uint8_t*)glMapBufferRange(GL_ARRAY_BUFFER, 0, vertexSize, flags);
+		indices = (uint32_t*)glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, indexSize, flags);
+
+		if (!vertices || !indices)
+		{
+			Logger::warn("Failed to map dynamic mesh buffers, falling back to uploads\n");
+			persistent = false;
+
+			if (vertices)
+				glUnmapBuffer(GL_ARRAY_BUFFER);
+			if (indices)
+				glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+
+			vertices = nullptr;
+			indices = nullptr;
+
+			// IMMUTABLE STORAGE CANNOT BE RESIZED, START OVER WITH NEW BUFFERS
+			glDeleteBuffers(1, &VBO);
+			glDeleteBuffers(1, &EBO);
+			glGenBuffers(1, &VBO);
+			glGenBuffers(1, &EBO);
+			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+		}
+	}
+
+	stagedVertices.resize((size_t)maxVertexCount * stride);
+	stagedIndices.resize(maxIndexCount);
+
+	if (!persistent)
+	{
+		glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)maxVertexCount * stride, nullptr, GL_STREAM_DRAW);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)maxIndexCount * sizeof(uint32_t), nullptr, GL_STREAM_DRAW);
+	}
+
+	setVertexAttributePointers(this->format);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+DynamicMeshBuffer::~DynamicMeshBuffer()
+{
+	for (void* fence : fences)
+		if (fence)
+			glDeleteSync((GLsync)fence);
+
+	if (persistent)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		// NOT BOUND TO ANY VAO, SO THE ELEMENT BINDING CAN BE USED FREELY
+		glBindVertexArray(0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+
+	glDeleteBuffers(1, &VBO);
+	glDeleteBuffers(1, &EBO);
+	glDeleteVertexArrays(1, &VAO);
+}
+
+bool DynamicMeshBuffer::stage(const std::vector<Vector3f>& positions, const std::vector<Vector3f>& normals, const std::vector<Vector3f>& colors, const std::vector<Vector3i>& faces)
+{
+	NEU_PROFILE_FUNCTION;
+
+	if (positions.size() > maxVertexCount || faces.size() * 3 > maxIndexCount)
+	{
+		Logger::error("Dynamic mesh update of %zu vertices and %zu faces exceeds its capacity\n", positions.size(), faces.size());
+		return false;
+	}
+
+	// A SECOND UPDATE BEFORE THE UPLOAD REPLACES THE FIRST IN THE SAME SEGMENT
+	if (!staged)
+		segment = (segment + 1) % SEGMENT_COUNT;
+
+	packVertices(format, positions, normals, colors, stagedVertices.data());
+	memcpy(stagedIndices.data(), faces.data(), faces.size() * sizeof(Vector3i));
+
+	stagedVertexCount = (uint32_t)positions.size();
+	stagedIndexCount = (uint32_t)(faces.size() * 3);
+	staged = true;
+
+	return true;
+}
+
+void DynamicMeshBuffer::upload()
+{
+	if (!staged)
+		return;
+
+	NEU_PROFILE_FUNCTION;
+
+	staged = false;
+
+	if (persistent)
+	{
+		advanceSegment();
+
+		memcpy(vertices + (size_t)getBaseVertex() * stride, stagedVertices.data(), (size_t)stagedVertexCount * stride);
+		memcpy(indices + getFirstIndex(), stagedIndices.data(), stagedIndexCount * sizeof(uint32_t));
+
+		return;
+	}
+
+	// ORPHAN SO THE DRIVER HANDS OUT FRESH MEMORY INSTEAD OF WAITING ON THE GPU
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)maxVertexCount * stride, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)stagedVertexCount * stride, stagedVertices.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// THE COPY TARGET AVOIDS TOUCHING THE ELEMENT BINDING OF THE BOUND VAO
+	glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+	glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)maxIndexCount * sizeof(uint32_t), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, 0, (GLsizeiptr)stagedIndexCount * sizeof(uint32_t), stagedIndices.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void DynamicMeshBuffer::advanceSegment()
+{
+	// EVERY DRAW OF THE UPLOADED SEGMENT HAS BEEN ISSUED BY NOW
+	if (fences[uploadedSegment])
+		glDeleteSync((GLsync)fences[uploadedSegment]);
+
+	fences[uploadedSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	uploadedSegment = segment;
+
+	// WAIT UNTIL THE GPU IS DONE READING THE SEGMENT WE ARE ABOUT TO FILL
+	if (fences[segment])
+	{
+		GLenum result = glClientWaitSync((GLsync)fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+		while (result == GL_TIMEOUT_EXPIRED)
+			result = glClientWaitSync((GLsync)fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+
+		glDeleteSync((GLsync)fences[segment]);
+		fences[segment] = nullptr;
+	}
+}
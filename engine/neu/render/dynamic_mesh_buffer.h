@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "math/Vector.h"
+
+namespace Neu
+{
+	/**
+	 * Streaming vertex and index storage for a mesh whose geometry is
+	 * rewritten every frame (cloth, CPU skinning, procedural meshes). Every
+	 * write goes to the next of SEGMENT_COUNT segments, so the CPU never
+	 * touches data the GPU may still be reading: with GL_ARB_buffer_storage
+	 * the buffers are persistently mapped and each segment is guarded by a
+	 * fence, otherwise the buffers are orphaned (GL_STREAM_DRAW) before each
+	 * upload. Positions are always stored at full precision.
+	 */
+	class DynamicMeshBuffer
+	{
+	public:
+		DynamicMeshBuffer(uint32_t format, uint32_t maxVertexCount, uint32_t maxIndexCount);
+		~DynamicMeshBuffer();
+
+		DynamicMeshBuffer(const DynamicMeshBuffer&) = delete;
+		DynamicMeshBuffer& operator=(const DynamicMeshBuffer&) = delete;
+
+		/**
+		 * Packs the geometry into CPU memory and reserves the next segment for
+		 * it. Does not call GL, so it can run on the simulation thread. Staging
+		 * again before the upload replaces the staged geometry. Returns false,
+		 * keeping the previous geometry, if it exceeds the capacity.
+		 */
+		bool stage(const std::vector<Vector3f>& positions, const std::vector<Vector3f>& normals, const std::vector<Vector3f>& colors, const std::vector<Vector3i>& faces);
+
+		/**
+		 * Copies the staged geometry into its segment, on the GL thread once
+		 * the draws of the previous geometry have been issued. Does nothing if
+		 * nothing was staged.
+		 */
+		void upload();
+
+		unsigned int getVAO() const { return VAO; }
+
+		// LOCATION OF THE LAST STAGED GEOMETRY
+		uint32_t getBaseVertex() const { return persistent ? segment * maxVertexCount : 0; }
+		uint32_t getFirstIndex() const { return persistent ? segment * maxIndexCount : 0; }
+
+	private:
+		// SEGMENTS IN FLIGHT, SO THE CPU NEVER WRITES WHAT THE GPU IS READING
+		static constexpr int SEGMENT_COUNT = 3;
+
+		/**
+		 * Fences the segment that was drawn so far and waits until the GPU is
+		 * done with the staged one.
+		 */
+		void advanceSegment();
+
+		uint32_t format;
+		uint32_t stride;
+
+		uint32_t maxVertexCount;
+		uint32_t maxIndexCount;
+
+		unsigned int VAO;
+		unsigned int VBO;
+		unsigned int EBO;
+
+		bool persistent;
+
+		// MAPPED BUFFERS (PERSISTENT ONLY)
+		uint8_t* vertices = nullptr;
+		uint32_t* indices = nullptr;
+
+		// GEOMETRY WAITING FOR upload()
+		std::vector<uint8_t> stagedVertices;
+		std::vector<uint32_t> stagedIndices;
+		uint32_t stagedVertexCount = 0;
+		uint32_t stagedIndexCount = 0;
+		bool staged = false;
+
+		// SEGMENT OF THE LAST STAGED AND OF THE LAST UPLOADED GEOMETRY. START
+		// ON THE LAST SEGMENT SO THE FIRST WRITE GOES TO SEGMENT 0
+		int segment = SEGMENT_COUNT - 1;
+		int uploadedSegment = SEGMENT_COUNT - 1;
+		void* fences[SEGMENT_COUNT] = {};
+	};
+}
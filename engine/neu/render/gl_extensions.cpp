@@ -0,0 +1,55 @@
+#include "gl_extensions.h"
+
+using namespace Neu;
+
+void GLExtensions::load()
+{
+	////////////////////////
+	// ARB_BUFFER_STORAGE //
+	////////////////////////
+
+	if (glfwExtensionSupported("GL_ARB_buffer_storage"))
+		bufferStorage = (PFNNEUBUFFERSTORAGEPROC)glfwGetProcAddress("glBufferStorage");
+
+	hasBufferStorage = bufferStorage != nullptr;
+
+	Logger::info("GL_ARB_buffer_storage: %s\n", hasBufferStorage ? "yes" : "no");
+
+	////////////////////////////
+	// ARB_GET_PROGRAM_BINARY //
+	////////////////////////////
+
+	if (glfwExtensionSupported("GL_ARB_get_program_binary"))
+	{
+		getProgramBinary = (PFNNEUGETPROGRAMBINARYPROC)glfwGetProcAddress("glGetProgramBinary");
+		programBinary = (PFNNEUPROGRAMBINARYPROC)glfwGetProcAddress("glProgramBinary");
+		programParameteri = (PFNNEUPROGRAMPARAMETERIPROC)glfwGetProcAddress("glProgramParameteri");
+	}
+
+	// SOME DRIVERS EXPOSE THE EXTENSION WITHOUT SUPPORTING A SINGLE FORMAT
+	GLint binaryFormatCount = 0;
+
+	if (getProgramBinary && programBinary && programParameteri)
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormatCount);
+
+	hasProgramBinary = binaryFormatCount > 0;
+
+	Logger::info("GL_ARB_get_program_binary: %s\n", hasProgramBinary ? "yes" : "no");
+
+	/////////////////////////////////
+	// KHR_PARALLEL_SHADER_COMPILE //
+	/////////////////////////////////
+
+	if (glfwExtensionSupported("GL_KHR_parallel_shader_compile"))
+		maxShaderCompilerThreads = (PFNNEUMAXSHADERCOMPILERTHREADSPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+	else if (glfwExtensionSupported("GL_ARB_parallel_shader_compile"))
+		maxShaderCompilerThreads = (PFNNEUMAXSHADERCOMPILERTHREADSPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+
+	hasParallelShaderCompile = maxShaderCompilerThreads != nullptr;
+
+	// LET THE DRIVER PICK THE NUMBER OF COMPILER THREADS
+	if (hasParallelShaderCompile)
+		maxShaderCompilerThreads(0xFFFFFFFF);
+
+	Logger::info("GL_KHR_parallel_shader_compile: %s\n", hasParallelShaderCompile ? "yes" : "no");
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "core.h"
+
+// THE GLAD LOADER ONLY COVERS CORE 3.3, NEWER ENTRY POINTS ARE LOADED HERE
+
+////////////////////////
+// ARB_BUFFER_STORAGE //
+////////////////////////
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+
+typedef void (*PFNNEUBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+////////////////////////////
+// ARB_GET_PROGRAM_BINARY //
+////////////////////////////
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define GL_PROGRAM_BINARY_FORMATS 0x87FF
+#endif
+
+typedef void (*PFNNEUGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (*PFNNEUPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (*PFNNEUPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+
+/////////////////////////////////
+// KHR_PARALLEL_SHADER_COMPILE //
+/////////////////////////////////
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+typedef void (*PFNNEUMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+
+namespace Neu
+{
+	/**
+	 * Optional OpenGL extensions. Call load() once the context is current; the
+	 * has* flags tell whether the matching entry points can be used.
+	 */
+	struct GLExtensions
+	{
+		static void load();
+
+		static inline bool hasBufferStorage = false;
+		static inline PFNNEUBUFFERSTORAGEPROC bufferStorage = nullptr;
+
+		static inline bool hasProgramBinary = false;
+		static inline PFNNEUGETPROGRAMBINARYPROC getProgramBinary = nullptr;
+		static inline PFNNEUPROGRAMBINARYPROC programBinary = nullptr;
+		static inline PFNNEUPROGRAMPARAMETERIPROC programParameteri = nullptr;
+
+		// PROGRAMS CAN BE POLLED WITH GL_COMPLETION_STATUS_KHR
+		static inline bool hasParallelShaderCompile = false;
+		static inline PFNNEUMAXSHADERCOMPILERTHREADSPROC maxShaderCompilerThreads = nullptr;
+	};
+}
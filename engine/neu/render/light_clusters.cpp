@@ -0,0 +1,392 @@
+#include "light_clusters.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "core.h"
+#include "scene/camera.h"
+#include "shader.h"
+#include "utility/simd.h"
+
+using namespace Neu;
+
+LightClusters::LightClusters()
+{
+	GLint maxTexels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+
+	// THE INDICES ARE 16-BIT, AND GL 3.3 GUARANTEES AT LEAST 64K TEXELS
+	maxIndexCount = (uint32_t)std::max(maxTexels, 65536);
+
+	clusterRanges.resize(CLUSTER_COUNT * 2);
+	clusterBounds.resize(CLUSTER_GRID_Y * CLUSTER_GRID_Z * BLOCKS_PER_ROW);
+
+	glGenBuffers(1, &gridBuffer);
+	glGenBuffers(1, &indexBuffer);
+	glGenBuffers(1, &lightBuffer);
+
+	glGenTextures(1, &gridTexture);
+	glGenTextures(1, &indexTexture);
+	glGenTextures(1, &lightTexture);
+
+	// A TEXTURE BUFFER NEEDS STORAGE BEFORE IT CAN BE SAMPLED
+	upload();
+
+	// ORPHANING KEEPS THE BUFFER OBJECTS, SO THE TEXTURES ONLY NEED TO BE
+	// ATTACHED ONCE
+	glBindTexture(GL_TEXTURE_BUFFER, gridTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, gridBuffer);
+
+	glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R16UI, indexBuffer);
+
+	glBindTexture(GL_TEXTURE_BUFFER, lightTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, lightBuffer);
+
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+LightClusters::~LightClusters()
+{
+	glDeleteTextures(1, &gridTexture);
+	glDeleteTextures(1, &indexTexture);
+	glDeleteTextures(1, &lightTexture);
+
+	glDeleteBuffers(1, &gridBuffer);
+	glDeleteBuffers(1, &indexBuffer);
+	glDeleteBuffers(1, &lightBuffer);
+}
+
+void LightClusters::clear()
+{
+	lights.clear();
+}
+
+void LightClusters::addLight(const Vector3f& position, float radius, const Vector3f& color, float intensity)
+{
+	if (getLightCount() >= CLUSTER_MAX_LIGHTS)
+	{
+		if (!lightsOverflowed)
+			Logger::warn("More than %d lights, the rest are ignored\n", CLUSTER_MAX_LIGHTS);
+
+		lightsOverflowed = true;
+		return;
+	}
+
+	lights.push_back(Vector4f(position.x, position.y, position.z, radius));
+	lights.push_back(Vector4f(color.x, color.y, color.z, intensity));
+}
+
+void LightClusters::update(const Camera& camera)
+{
+	NEU_PROFILE_FUNCTION;
+
+	const float* projection = camera.getProjectionMatrix();
+	const float nearPlane = camera.getNearPlane();
+	const float farPlane = camera.getFarPlane();
+	const Vector2i resolution = camera.getResolution();
+
+	if (projection[0] != boundsProjection[0] || projection[5] != boundsProjection[1] || nearPlane != boundsProjection[2] || farPlane != boundsProjection[3])
+		buildClusterBounds(projection[0], projection[5], nearPlane, farPlane);
+
+	const float logDepthRange = std::log(farPlane / nearPlane);
+
+	parameters.gridSize[0] = CLUSTER_GRID_X;
+	parameters.gridSize[1] = CLUSTER_GRID_Y;
+	parameters.gridSize[2] = CLUSTER_GRID_Z;
+	parameters.sliceScale = CLUSTER_GRID_Z / logDepthRange;
+	parameters.sliceBias = -CLUSTER_GRID_Z * std::log(nearPlane) / logDepthRange;
+	parameters.tileScaleX = (float)CLUSTER_GRID_X / std::max(resolution.x, 1);
+	parameters.tileScaleY = (float)CLUSTER_GRID_Y / std::max(resolution.y, 1);
+
+	auto getSlice = [&](float depth)
+	{
+		int slice = (int)std::floor(std::log(depth) * parameters.sliceScale + parameters.sliceBias);
+		return std::clamp(slice, 0, CLUSTER_GRID_Z - 1);
+	};
+
+	auto getTile = [](float ndc, int tileCount)
+	{
+		int tile = (int)std::floor((ndc * 0.5f + 0.5f) * tileCount);
+		return std::clamp(tile, 0, tileCount - 1);
+	};
+
+	////////////
+	// ASSIGN //
+	////////////
+
+	const Matrix4x4f view = camera.getViewMatrix();
+
+	assignments.clear();
+
+	for (uint32_t light = 0; light < (uint32_t)getLightCount(); light++)
+	{
+		const Vector4f& sphere = lights[light * 2];
+		const float radius = sphere.w;
+
+		Vector3f center;
+		for (int row = 0; row < 3; row++)
+			center[row] = view(row, 0) * sphere.x + view(row, 1) * sphere.y + view(row, 2) * sphere.z + view(row, 3);
+
+		// THE PROJECTION LOOKS DOWN -Z
+		const float nearDepth = std::max(-center.z - radius, nearPlane);
+		const float farDepth = std::min(-center.z + radius, farPlane);
+
+		if (nearDepth > farDepth)
+			continue;
+
+		// X / DEPTH IS MONOTONIC IN DEPTH, SO THE EXTREMES OF THE SPHERE'S
+		// BOUNDING BOX ARE AT THE NEAREST OR FARTHEST DEPTH
+		auto getTileRange = [&](float centerCoordinate, float projectionScale, int tileCount, int& first, int& last)
+		{
+			const float low = centerCoordinate - radius;
+			const float high = centerCoordinate + radius;
+
+			first = getTile(std::min(low / nearDepth, low / farDepth) * projectionScale, tileCount);
+			last = getTile(std::max(high / nearDepth, high / farDepth) * projectionScale, tileCount);
+		};
+
+		int firstX, lastX, firstY, lastY;
+		getTileRange(center.x, projection[0], CLUSTER_GRID_X, firstX, lastX);
+		getTileRange(center.y, projection[5], CLUSTER_GRID_Y, firstY, lastY);
+
+		const int firstZ = getSlice(nearDepth);
+		const int lastZ = getSlice(farDepth);
+
+		for (int z = firstZ; z <= lastZ; z++)
+			for (int y = firstY; y <= lastY; y++)
+				assignRow(y + CLUSTER_GRID_Y * z, firstX, lastX, center, radius, light);
+	}
+
+	//////////////////////
+	// GROUP BY CLUSTER //
+	//////////////////////
+
+	// COUNTING SORT INTO ONE INDEX RANGE PER CLUSTER
+	std::fill(clusterRanges.begin(), clusterRanges.end(), 0);
+
+	const size_t indexCount = std::min(assignments.size(), (size_t)maxIndexCount);
+
+	for (size_t i = 0; i < indexCount; i++)
+		clusterRanges[(assignments[i] >> 16) * 2 + 1]++;
+
+	uint32_t offset = 0;
+
+	for (uint32_t cluster = 0; cluster < CLUSTER_COUNT; cluster++)
+	{
+		clusterRanges[cluster * 2] = offset;
+		offset += clusterRanges[cluster * 2 + 1];
+	}
+
+	lightIndices.resize(indexCount);
+
+	// FILL EACH RANGE FROM THE BACK (THE COUNT RUNS DOWN TO ZERO), WALKING THE
+	// ASSIGNMENTS BACKWARDS SO THE LIGHTS STAY IN ORDER
+	for (size_t i = indexCount; i-- > 0;)
+	{
+		const uint32_t cluster = assignments[i] >> 16;
+		const uint32_t next = clusterRanges[cluster * 2] + clusterRanges[cluster * 2 + 1] - 1;
+
+		lightIndices[next] = (uint16_t)(assignments[i] & 0xFFFF);
+		clusterRanges[cluster * 2 + 1]--;
+	}
+
+	// RESTORE THE COUNTS
+	for (uint32_t cluster = 0; cluster + 1 < CLUSTER_COUNT; cluster++)
+		clusterRanges[cluster * 2 + 1] = clusterRanges[(cluster + 1) * 2] - clusterRanges[cluster * 2];
+
+	clusterRanges[(CLUSTER_COUNT - 1) * 2 + 1] = (uint32_t)indexCount - clusterRanges[(CLUSTER_COUNT - 1) * 2];
+
+	if (indexCount < assignments.size() && !indicesOverflowed)
+	{
+		Logger::warn("Cluster light index list is full, some lights are dropped\n");
+		indicesOverflowed = true;
+	}
+
+	upload();
+}
+
+void LightClusters::bindTextures() const
+{
+	glActiveTexture(GL_TEXTURE0 + CLUSTER_GRID_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, gridTexture);
+
+	glActiveTexture(GL_TEXTURE0 + CLUSTER_INDEX_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+
+	glActiveTexture(GL_TEXTURE0 + CLUSTER_LIGHT_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, lightTexture);
+
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void LightClusters::setSamplers(Shader& shader)
+{
+	// NO-OPS FOR SHADERS WITHOUT THESE UNIFORMS, AND CACHED AFTER THE FIRST CALL
+	shader.setInteger("cluster_grid", CLUSTER_GRID_TEXTURE_UNIT);
+	shader.setInteger("cluster_light_indices", CLUSTER_INDEX_TEXTURE_UNIT);
+	shader.setInteger("cluster_lights", CLUSTER_LIGHT_TEXTURE_UNIT);
+}
+
+////////////////////
+// CLUSTER BOUNDS //
+////////////////////
+
+void LightClusters::buildClusterBounds(float projectionX, float projectionY, float nearPlane, float farPlane)
+{
+	boundsProjection[0] = projectionX;
+	boundsProjection[1] = projectionY;
+	boundsProjection[2] = nearPlane;
+	boundsProjection[3] = farPlane;
+
+	// EXPONENTIAL SLICES KEEP CLUSTERS ROUGHLY CUBIC WITH DEPTH
+	auto getSliceDepth = [&](int slice)
+	{
+		return nearPlane * std::pow(farPlane / nearPlane, (float)slice / CLUSTER_GRID_Z);
+	};
+
+	for (int z = 0; z < CLUSTER_GRID_Z; z++)
+	{
+		const float nearDepth = getSliceDepth(z);
+		const float farDepth = getSliceDepth(z + 1);
+
+		for (int y = 0; y < CLUSTER_GRID_Y; y++)
+		{
+			const float bottom = (2.0f * y / CLUSTER_GRID_Y - 1.0f) / projectionY;
+			const float top = (2.0f * (y + 1) / CLUSTER_GRID_Y - 1.0f) / projectionY;
+
+			ClusterBoundsBlock* row = &clusterBounds[(y + CLUSTER_GRID_Y * z) * BLOCKS_PER_ROW];
+
+			for (int x = 0; x < BLOCKS_PER_ROW * 8; x++)
+			{
+				ClusterBoundsBlock& block = row[x / 8];
+				const int lane = x % 8;
+
+				// PADDING LANES GET AN EMPTY BOX THAT NOTHING INTERSECTS
+				if (x >= CLUSTER_GRID_X)
+				{
+					block.minX[lane] = block.minY[lane] = block.minZ[lane] = INFINITY;
+					block.maxX[lane] = block.maxY[lane] = block.maxZ[lane] = -INFINITY;
+					continue;
+				}
+
+				const float left = (2.0f * x / CLUSTER_GRID_X - 1.0f) / projectionX;
+				const float right = (2.0f * (x + 1) / CLUSTER_GRID_X - 1.0f) / projectionX;
+
+				// THE CLUSTER IS A FRUSTUM SLICE, BOX IT AT BOTH OF ITS DEPTHS
+				block.minX[lane] = std::min(left * nearDepth, left * farDepth);
+				block.maxX[lane] = std::max(right * nearDepth, right * farDepth);
+				block.minY[lane] = std::min(bottom * nearDepth, bottom * farDepth);
+				block.maxY[lane] = std::max(top * nearDepth, top * farDepth);
+				block.minZ[lane] = -farDepth;
+				block.maxZ[lane] = -nearDepth;
+			}
+		}
+	}
+}
+
+#ifdef NEU_SIMD_SSE2
+
+/**
+ * Sphere against the boxes of S::width clusters at once. Returns one bit per
+ * intersecting cluster.
+ */
+template <typename S>
+static int intersectClusters(const float* minX, const float* minY, const float* minZ, const float* maxX, const float* maxY, const float* maxZ, const Vector3f& center, float radius)
+{
+	using Float = typename S::Float;
+
+	const Float zero = S::set1(0.0f);
+
+	auto axisDistance = [&](const float* minimum, const float* maximum, float coordinate)
+	{
+		const Float value = S::set1(coordinate);
+
+		// DISTANCE OUTSIDE THE BOX ALONG ONE AXIS, ZERO INSIDE
+		Float distance = S::max(S::sub(S::load(minimum), value), zero);
+		distance = S::max(S::sub(value, S::load(maximum)), distance);
+		return S::mul(distance, distance);
+	};
+
+	Float squaredDistance = axisDistance(minX, maxX, center.x);
+	squaredDistance = S::add(squaredDistance, axisDistance(minY, maxY, center.y));
+	squaredDistance = S::add(squaredDistance, axisDistance(minZ, maxZ, center.z));
+
+	return S::moveMask(S::lessEqual(squaredDistance, S::set1(radius * radius)));
+}
+
+#endif
+
+void LightClusters::assignRow(uint32_t rowIndex, int firstX, int lastX, const Vector3f& center, float radius, uint32_t light)
+{
+	const ClusterBoundsBlock* row = &clusterBounds[rowIndex * BLOCKS_PER_ROW];
+
+	for (int blockIndex = firstX / 8; blockIndex <= lastX / 8; blockIndex++)
+	{
+		const ClusterBoundsBlock& block = row[blockIndex];
+
+		uint32_t mask = 0;
+
+#ifdef NEU_SIMD_SSE2
+		for (int lane = 0; lane < 8; lane += SimdBest::width)
+		{
+			mask |= (uint32_t)intersectClusters<SimdBest>(block.minX + lane, block.minY + lane, block.minZ + lane, block.maxX + lane, block.maxY + lane, block.maxZ + lane, center, radius) << lane;
+		}
+#else
+		for (int lane = 0; lane < 8; lane++)
+		{
+			float squaredDistance = 0.0f;
+			const float minimum[3] = { block.minX[lane], block.minY[lane], block.minZ[lane] };
+			const float maximum[3] = { block.maxX[lane], block.maxY[lane], block.maxZ[lane] };
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float distance = std::max({ minimum[axis] - center[axis], center[axis] - maximum[axis], 0.0f });
+				squaredDistance += distance * distance;
+			}
+
+			if (squaredDistance <= radius * radius)
+				mask |= 1u << lane;
+		}
+#endif
+
+		// ONLY THE TILES IN [firstX, lastX]
+		const int blockStart = blockIndex * 8;
+		const uint32_t rangeMask = (0xFFu << std::max(firstX - blockStart, 0)) & (0xFFu >> std::max(blockStart + 7 - lastX, 0));
+
+		mask &= rangeMask;
+
+		while (mask)
+		{
+			const int lane = std::countr_zero(mask);
+			mask &= mask - 1;
+
+			const uint32_t cluster = (blockStart + lane) + CLUSTER_GRID_X * rowIndex;
+			assignments.push_back((cluster << 16) | light);
+		}
+	}
+}
+
+////////////
+// UPLOAD //
+////////////
+
+void LightClusters::upload()
+{
+	// ORPHAN LAST FRAME'S STORAGE SO THE UPLOAD DOES NOT WAIT ON THE GPU
+	auto uploadBuffer = [](unsigned int buffer, const void* data, size_t size)
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+		glBufferData(GL_TEXTURE_BUFFER, std::max(size, (size_t)16), nullptr, GL_STREAM_DRAW);
+
+		if (size > 0)
+			glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+	};
+
+	uploadBuffer(gridBuffer, clusterRanges.data(), clusterRanges.size() * sizeof(uint32_t));
+	uploadBuffer(indexBuffer, lightIndices.data(), lightIndices.size() * sizeof(uint16_t));
+	uploadBuffer(lightBuffer, lights.data(), lights.size() * sizeof(Vector4f));
+
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
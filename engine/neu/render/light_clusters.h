@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "math/Matrix.h"
+#include "math/Vector.h"
+
+// FRUSTUM SUBDIVISION: SCREEN TILES IN X AND Y, EXPONENTIAL DEPTH SLICES IN Z.
+// THE SAME VALUES REACH THE SHADER THROUGH THE CLUSTERS UNIFORM BLOCK
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
+#define CLUSTER_COUNT (CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z)
+
+#define CLUSTER_MAX_LIGHTS 1024
+
+// TEXTURE UNITS OF THE CLUSTER TEXTURE BUFFERS (UNIT 0 IS THE SHADOW MAP)
+#define CLUSTER_GRID_TEXTURE_UNIT 1
+#define CLUSTER_INDEX_TEXTURE_UNIT 2
+#define CLUSTER_LIGHT_TEXTURE_UNIT 3
+
+namespace Neu
+{
+	class Camera;
+	class Shader;
+
+	/**
+	 * Std140 layout of the "clusters" uniform block in light.frag.
+	 */
+	struct ClusterParameters
+	{
+		uint32_t gridSize[4];
+
+		// SLICE = LOG(DEPTH) * SCALE + BIAS
+		float sliceScale;
+		float sliceBias;
+
+		// TILES PER PIXEL
+		float tileScaleX;
+		float tileScaleY;
+	};
+
+	/**
+	 * Clustered forward lighting. The view frustum is split into a grid of
+	 * clusters and every point light is assigned to the clusters its sphere
+	 * touches, so a fragment only evaluates the lights of its own cluster.
+	 *
+	 * Per frame, call clear(), addLight() for every light and update(). The
+	 * result is uploaded into three texture buffers:
+	 *   grid     RG32UI   (offset, count) into the index list, per cluster
+	 *   indices  R16UI    light indices, grouped by cluster
+	 *   lights   RGBA32F  two texels per light: position + radius, color +
+	 *                     intensity
+	 */
+	class LightClusters
+	{
+	public:
+		LightClusters();
+		~LightClusters();
+
+		LightClusters(const LightClusters&) = delete;
+		LightClusters& operator=(const LightClusters&) = delete;
+
+		void clear();
+		void addLight(const Vector3f& position, float radius, const Vector3f& color, float intensity);
+
+		/**
+		 * Assigns the lights to the clusters of the camera frustum and uploads
+		 * the texture buffers. The caller uploads getParameters() to the
+		 * clusters uniform block.
+		 */
+		void update(const Camera& camera);
+
+		/**
+		 * Binds the texture buffers to their units. Shaders also need
+		 * setSamplers once, while in use.
+		 */
+		void bindTextures() const;
+		static void setSamplers(Shader& shader);
+
+		// CONTENTS OF THE CLUSTERS UNIFORM BLOCK FOR THE LAST UPDATE
+		const ClusterParameters& getParameters() const { return parameters; }
+
+		size_t getLightCount() const { return lights.size() / 2; }
+		size_t getLightIndexCount() const { return lightIndices.size(); }
+
+	private:
+		// VIEW SPACE BOUNDS OF 8 NEIGHBOURING CLUSTERS ALONG X, LAID OUT FOR
+		// SIMD LOADS
+		struct alignas(32) ClusterBoundsBlock
+		{
+			float minX[8];
+			float minY[8];
+			float minZ[8];
+			float maxX[8];
+			float maxY[8];
+			float maxZ[8];
+		};
+
+		static constexpr int BLOCKS_PER_ROW = (CLUSTER_GRID_X + 7) / 8;
+
+		/**
+		 * Recomputes the cluster bounds, only needed when the projection
+		 * changes.
+		 */
+		void buildClusterBounds(float projectionX, float projectionY, float nearPlane, float farPlane);
+
+		/**
+		 * Appends the clusters of the [firstX, lastX] range of a row that
+		 * intersect the sphere to assignments.
+		 */
+		void assignRow(uint32_t rowIndex, int firstX, int lastX, const Vector3f& center, float radius, uint32_t light);
+
+		void upload();
+
+		// WORLD SPACE, TWO TEXELS PER LIGHT
+		std::vector<Vector4f> lights;
+
+		// ONE BLOCK ROW PER (Y, Z)
+		std::vector<ClusterBoundsBlock> clusterBounds;
+
+		// PROJECTION THE BOUNDS WERE BUILT FOR
+		float boundsProjection[4] = {};
+
+		ClusterParameters parameters = {};
+
+		// (CLUSTER << 16) | LIGHT, IN LIGHT ORDER
+		std::vector<uint32_t> assignments;
+
+		std::vector<uint32_t> clusterRanges;  // OFFSET, COUNT PER CLUSTER
+		std::vector<uint16_t> lightIndices;
+
+		// TEXTURE BUFFERS CANNOT HOLD MORE TEXELS THAN THIS
+		uint32_t maxIndexCount;
+
+		// ONLY WARN ONCE
+		bool lightsOverflowed = false;
+		bool indicesOverflowed = false;
+
+		unsigned int gridBuffer;
+		unsigned int indexBuffer;
+		unsigned int lightBuffer;
+
+		unsigned int gridTexture;
+		unsigned int indexTexture;
+		unsigned int lightTexture;
+	};
+}
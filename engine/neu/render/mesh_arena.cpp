@@ -0,0 +1,405 @@
+#include "mesh_arena.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "components/mesh.h"
+#include "render/dynamic_mesh_buffer.h"
+#include "core.h"
+
+using namespace Neu;
+
+// INITIAL POOL SIZES, POOLS DOUBLE WHEN THEY RUN OUT
+#define MESH_ARENA_VERTEX_CAPACITY (64 * 1024)
+#define MESH_ARENA_INDEX_CAPACITY (192 * 1024)
+
+/**
+ * 64-bit FNV-1a, chained through hash so several arrays can be combined.
+ */
+static uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+/////////////////////
+// RANGE ALLOCATOR //
+/////////////////////
+
+uint32_t MeshArena::RangeAllocator::allocate(uint32_t count)
+{
+	for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it)
+	{
+		if (it->second < count)
+			continue;
+
+		uint32_t offset = it->first;
+		uint32_t remaining = it->second - count;
+
+		freeRanges.erase(it);
+
+		if (remaining > 0)
+			freeRanges[offset + count] = remaining;
+
+		used += count;
+		return offset;
+	}
+
+	return INVALID_OFFSET;
+}
+
+void MeshArena::RangeAllocator::free(uint32_t offset, uint32_t count)
+{
+	used -= count;
+
+	auto next = freeRanges.lower_bound(offset);
+
+	// MERGE WITH THE FOLLOWING RANGE
+	if (next != freeRanges.end() && offset + count == next->first)
+	{
+		count += next->second;
+		next = freeRanges.erase(next);
+	}
+
+	// MERGE WITH THE PRECEDING RANGE
+	if (next != freeRanges.begin())
+	{
+		auto previous = std::prev(next);
+
+		if (previous->first + previous->second == offset)
+		{
+			previous->second += count;
+			return;
+		}
+	}
+
+	freeRanges[offset] = count;
+}
+
+void MeshArena::RangeAllocator::grow(uint32_t newCapacity)
+{
+	uint32_t oldCapacity = capacity;
+	capacity = newCapacity;
+
+	// COUNTED AS USED SO free() CAN BALANCE IT
+	used += newCapacity - oldCapacity;
+	free(oldCapacity, newCapacity - oldCapacity);
+}
+
+////////////////
+// MESH ARENA //
+////////////////
+
+MeshArena::MeshArena() = default;
+
+MeshArena::~MeshArena()
+{
+	for (Pool& pool : pools)
+	{
+		if (!pool.VAO)
+			continue;
+
+		glDeleteVertexArrays(1, &pool.VAO);
+		glDeleteBuffers(1, &pool.VBO);
+		glDeleteBuffers(1, &pool.EBO);
+	}
+}
+
+std::shared_ptr<Mesh> MeshArena::createMesh(const std::vector<Vector3f>& positions, const std::vector<Vector3f>& normals, const std::vector<Vector3f>& colors, const std::vector<Vector3i>& faces, PositionPrecision precision)
+{
+	if (positions.empty() || faces.empty())
+	{
+		Logger::error("Cannot create a mesh without vertices or faces\n");
+		return nullptr;
+	}
+
+	if ((!normals.empty() && normals.size() != positions.size()) || (!colors.empty() && colors.size() != positions.size()))
+	{
+		Logger::error("Mesh attributes must have one entry per position\n");
+		return nullptr;
+	}
+
+	const uint32_t format = chooseVertexFormat(positions, !normals.empty(), !colors.empty(), precision);
+
+	///////////////////
+	// DEDUPLICATION //
+	///////////////////
+
+	uint64_t hash = hashBytes(&format, sizeof(format));
+	hash = hashBytes(positions.data(), positions.size() * sizeof(Vector3f), hash);
+	hash = hashBytes(normals.data(), normals.size() * sizeof(Vector3f), hash);
+	hash = hashBytes(colors.data(), colors.size() * sizeof(Vector3f), hash);
+	hash = hashBytes(faces.data(), faces.size() * sizeof(Vector3i), hash);
+
+	Pool& pool = getPool(format);
+
+	const uint32_t vertexCount = (uint32_t)positions.size();
+	const uint32_t indexCount = (uint32_t)faces.size() * 3;
+
+	std::vector<uint8_t> vertexData((size_t)vertexCount * pool.stride);
+	packVertices(format, positions, normals, colors, vertexData.data());
+
+	auto existing = meshes.find(hash);
+
+	if (existing != meshes.end())
+	{
+		std::shared_ptr<Mesh> mesh = existing->second.lock();
+
+		// THE HASH ONLY FINDS THE CANDIDATE, A COLLISION MUST NOT DRAW ANOTHER
+		// MESH'S GEOMETRY
+		if (mesh && mesh->format == format && holdsGeometry(*mesh, vertexData, faces))
+			return mesh;
+	}
+
+	////////////////
+	// ALLOCATION //
+	////////////////
+
+	uint32_t baseVertex = pool.vertices.allocate(vertexCount);
+
+	if (baseVertex == RangeAllocator::INVALID_OFFSET)
+	{
+		growVertices(pool, vertexCount);
+		baseVertex = pool.vertices.allocate(vertexCount);
+	}
+
+	uint32_t firstIndex = pool.indices.allocate(indexCount);
+
+	if (firstIndex == RangeAllocator::INVALID_OFFSET)
+	{
+		growIndices(pool, indexCount);
+		firstIndex = pool.indices.allocate(indexCount);
+	}
+
+	////////////
+	// UPLOAD //
+	////////////
+
+	glBindBuffer(GL_ARRAY_BUFFER, pool.VBO);
+	glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)baseVertex * pool.stride, vertexData.size(), vertexData.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// INDICES STAY RELATIVE TO THE MESH, THE DRAW ADDS THE BASE VERTEX
+	glBindBuffer(GL_COPY_WRITE_BUFFER, pool.EBO);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)firstIndex * sizeof(uint32_t), indexCount * sizeof(uint32_t), faces.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	std::shared_ptr<Mesh> mesh(new Mesh());
+	mesh->arena = this;
+	mesh->id = nextMeshID++;
+	mesh->format = format;
+	mesh->hash = hash;
+	mesh->baseVertex = baseVertex;
+	mesh->vertexCount = vertexCount;
+	mesh->firstIndex = firstIndex;
+	mesh->indexCount = indexCount;
+
+	for (const Vector3f& position : positions)
+		mesh->bounds.expand(position);
+
+	meshes[hash] = mesh;
+
+	return mesh;
+}
+
+std::shared_ptr<Mesh> MeshArena::createDynamicMesh(uint32_t attributes, uint32_t maxVertexCount, uint32_t maxIndexCount)
+{
+	const uint32_t format = attributes & (VERTEX_NORMAL | VERTEX_COLOR);
+
+	std::shared_ptr<Mesh> mesh(new Mesh());
+	mesh->arena = this;
+	mesh->id = nextMeshID++;
+	mesh->format = format;
+	mesh->dynamicBuffer = std::make_unique<DynamicMeshBuffer>(format, maxVertexCount, maxIndexCount);
+
+	std::lock_guard<std::mutex> lock(dynamicBuffersMutex);
+	dynamicBuffers.push_back(mesh->dynamicBuffer.get());
+
+	return mesh;
+}
+
+void MeshArena::uploadDynamicMeshes()
+{
+	std::lock_guard<std::mutex> lock(dynamicBuffersMutex);
+
+	retiredBuffers.clear();
+
+	for (DynamicMeshBuffer* buffer : dynamicBuffers)
+		buffer->upload();
+}
+
+size_t MeshArena::getVertexCount() const
+{
+	size_t count = 0;
+
+	for (const Pool& pool : pools)
+		count += pool.vertices.getUsed();
+
+	return count;
+}
+
+size_t MeshArena::getVertexBytes() const
+{
+	size_t bytes = 0;
+
+	for (const Pool& pool : pools)
+		bytes += (size_t)pool.vertices.getUsed() * pool.stride;
+
+	return bytes;
+}
+
+size_t MeshArena::getIndexCount() const
+{
+	size_t count = 0;
+
+	for (const Pool& pool : pools)
+		count += pool.indices.getUsed();
+
+	return count;
+}
+
+MeshArena::Pool& MeshArena::getPool(uint32_t format)
+{
+	Pool& pool = pools[format];
+
+	if (pool.VAO)
+		return pool;
+
+	pool.stride = VertexLayout::get(format).stride;
+
+	glGenVertexArrays(1, &pool.VAO);
+	glGenBuffers(1, &pool.VBO);
+	glGenBuffers(1, &pool.EBO);
+
+	glBindBuffer(GL_ARRAY_BUFFER, pool.VBO);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)MESH_ARENA_VERTEX_CAPACITY * pool.stride, nullptr, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindVertexArray(pool.VAO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, MESH_ARENA_INDEX_CAPACITY * sizeof(uint32_t), nullptr, GL_STATIC_DRAW);
+	glBindVertexArray(0);
+
+	pool.vertices.grow(MESH_ARENA_VERTEX_CAPACITY);
+	pool.indices.grow(MESH_ARENA_INDEX_CAPACITY);
+
+	bindVertexAttributes(pool, format);
+
+	return pool;
+}
+
+void MeshArena::growVertices(Pool& pool, uint32_t minimumCount)
+{
+	const uint32_t oldCapacity = pool.vertices.getCapacity();
+	const uint32_t newCapacity = std::max(oldCapacity * 2, oldCapacity + minimumCount);
+
+	unsigned int newVBO;
+	glGenBuffers(1, &newVBO);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newVBO);
+	glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)newCapacity * pool.stride, nullptr, GL_STATIC_DRAW);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, pool.VBO);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, (GLsizeiptr)oldCapacity * pool.stride);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	glDeleteBuffers(1, &pool.VBO);
+	pool.VBO = newVBO;
+
+	pool.vertices.grow(newCapacity);
+
+	// THE VAO STILL REFERENCES THE DELETED BUFFER
+	bindVertexAttributes(pool, (uint32_t)(&pool - pools.data()));
+}
+
+void MeshArena::growIndices(Pool& pool, uint32_t minimumCount)
+{
+	const uint32_t oldCapacity = pool.indices.getCapacity();
+	const uint32_t newCapacity = std::max(oldCapacity * 2, oldCapacity + minimumCount);
+
+	unsigned int newEBO;
+	glGenBuffers(1, &newEBO);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newEBO);
+	glBufferData(GL_COPY_WRITE_BUFFER, newCapacity * sizeof(uint32_t), nullptr, GL_STATIC_DRAW);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, pool.EBO);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldCapacity * sizeof(uint32_t));
+
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	glDeleteBuffers(1, &pool.EBO);
+	pool.EBO = newEBO;
+
+	pool.indices.grow(newCapacity);
+
+	// THE ELEMENT BUFFER BINDING IS PART OF THE VAO STATE
+	glBindVertexArray(pool.VAO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.EBO);
+	glBindVertexArray(0);
+}
+
+void MeshArena::bindVertexAttributes(Pool& pool, uint32_t format)
+{
+	glBindVertexArray(pool.VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, pool.VBO);
+
+	setVertexAttributePointers(format);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+bool MeshArena::holdsGeometry(const Mesh& mesh, const std::vector<uint8_t>& vertexData, const std::vector<Vector3i>& faces)
+{
+	if (mesh.dynamicBuffer || mesh.vertexCount * (size_t)pools[mesh.format].stride != vertexData.size() || mesh.indexCount != faces.size() * 3)
+		return false;
+
+	const Pool& pool = pools[mesh.format];
+
+	// READ BACK FROM THE ARENA, ONLY HAPPENS WHEN LOADING A DUPLICATE
+	std::vector<uint8_t> storedVertices(vertexData.size());
+	std::vector<uint32_t> storedIndices(mesh.indexCount);
+
+	// THE READ TARGET AVOIDS TOUCHING THE ELEMENT BINDING OF THE BOUND VAO
+	glBindBuffer(GL_COPY_READ_BUFFER, pool.VBO);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, (GLintptr)mesh.baseVertex * pool.stride, storedVertices.size(), storedVertices.data());
+	glBindBuffer(GL_COPY_READ_BUFFER, pool.EBO);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, (GLintptr)mesh.firstIndex * sizeof(uint32_t), storedIndices.size() * sizeof(uint32_t), storedIndices.data());
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	return memcmp(storedVertices.data(), vertexData.data(), vertexData.size()) == 0 &&
+		memcmp(storedIndices.data(), faces.data(), faces.size() * sizeof(Vector3i)) == 0;
+}
+
+void MeshArena::release(Mesh* mesh)
+{
+	Pool& pool = pools[mesh->format];
+
+	pool.vertices.free(mesh->baseVertex, mesh->vertexCount);
+	pool.indices.free(mesh->firstIndex, mesh->indexCount);
+
+	// THE ENTRY MAY ALREADY POINT AT A NEWER MESH WITH THE SAME HASH
+	auto it = meshes.find(mesh->hash);
+
+	if (it != meshes.end() && it->second.expired())
+		meshes.erase(it);
+}
+
+void MeshArena::retire(std::unique_ptr<DynamicMeshBuffer> buffer)
+{
+	std::lock_guard<std::mutex> lock(dynamicBuffersMutex);
+
+	dynamicBuffers.erase(std::find(dynamicBuffers.begin(), dynamicBuffers.end(), buffer.get()));
+	retiredBuffers.push_back(std::move(buffer));
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "math/Vector.h"
+#include "render/vertex_format.h"
+
+namespace Neu
+{
+	class Mesh;
+	class DynamicMeshBuffer;
+
+	/**
+	 * Owns the GPU storage of all static mesh geometry. Every vertex format
+	 * has one interleaved vertex buffer, one index buffer and one VAO, and
+	 * meshes are suballocated from them, so drawing different meshes of the
+	 * same format never changes the bound vertex array (draws use base-vertex
+	 * offsets instead). Uploading geometry that is already in the arena
+	 * returns the existing mesh.
+	 */
+	class MeshArena
+	{
+	public:
+		// OUT OF LINE, THE RETIRED BUFFERS ARE INCOMPLETE HERE
+		MeshArena();
+		~MeshArena();
+
+		MeshArena(const MeshArena&) = delete;
+		MeshArena& operator=(const MeshArena&) = delete;
+
+		/**
+		 * Uploads a mesh, or returns the mesh that already holds the same
+		 * geometry. Normals and colors may be empty; if given, they must have
+		 * one entry per position. The vertices are packed into the format
+		 * described in vertex_format.h, with precision deciding whether
+		 * positions are stored as halfs.
+		 */
+		std::shared_ptr<Mesh> createMesh(const std::vector<Vector3f>& positions, const std::vector<Vector3f>& normals, const std::vector<Vector3f>& colors, const std::vector<Vector3i>& faces, PositionPrecision precision = POSITION_PRECISION_AUTO);
+
+		/**
+		 * Creates a mesh with its own streaming storage for geometry that
+		 * changes every frame (see DynamicMeshBuffer). attributes is a
+		 * combination of VERTEX_NORMAL and VERTEX_COLOR. The mesh is empty
+		 * until its first update.
+		 */
+		std::shared_ptr<Mesh> createDynamicMesh(uint32_t attributes, uint32_t maxVertexCount, uint32_t maxIndexCount);
+
+		/**
+		 * Uploads the geometry staged by Mesh::update since the last call and
+		 * deletes the storage of destroyed dynamic meshes. Called on the GL
+		 * thread between frames, while the simulation is idle.
+		 */
+		void uploadDynamicMeshes();
+
+		unsigned int getVAO(uint32_t format) const { return pools[format].VAO; }
+
+		size_t getMeshCount() const { return meshes.size(); }
+		size_t getVertexCount() const;
+		size_t getIndexCount() const;
+
+		// BYTES OF VERTEX DATA IN USE ACROSS ALL FORMATS
+		size_t getVertexBytes() const;
+
+	private:
+		friend class Mesh;
+
+		/**
+		 * First-fit allocator over [0, capacity) that merges neighbouring
+		 * free ranges.
+		 */
+		class RangeAllocator
+		{
+		public:
+			static constexpr uint32_t INVALID_OFFSET = UINT32_MAX;
+
+			uint32_t allocate(uint32_t count);
+			void free(uint32_t offset, uint32_t count);
+
+			// ADDS [capacity, newCapacity) TO THE FREE RANGES
+			void grow(uint32_t newCapacity);
+
+			uint32_t getCapacity() const { return capacity; }
+			uint32_t getUsed() const { return used; }
+
+		private:
+			std::map<uint32_t, uint32_t> freeRanges;  // OFFSET -> COUNT
+			uint32_t capacity = 0;
+			uint32_t used = 0;
+		};
+
+		// STORAGE SHARED BY ALL MESHES OF ONE VERTEX FORMAT
+		struct Pool
+		{
+			unsigned int VAO = 0;
+			unsigned int VBO = 0;
+			unsigned int EBO = 0;
+
+			uint32_t stride = 0;
+
+			RangeAllocator vertices;
+			RangeAllocator indices;
+		};
+
+		Pool& getPool(uint32_t format);
+
+		/**
+		 * Moves the buffer contents to a larger buffer and points the VAO at
+		 * it.
+		 */
+		void growVertices(Pool& pool, uint32_t minimumCount);
+		void growIndices(Pool& pool, uint32_t minimumCount);
+
+		void bindVertexAttributes(Pool& pool, uint32_t format);
+
+		/**
+		 * True if mesh stores exactly the packed vertices and the faces, which
+		 * are compared against the contents of the arena buffers.
+		 */
+		bool holdsGeometry(const Mesh& mesh, const std::vector<uint8_t>& vertexData, const std::vector<Vector3i>& faces);
+
+		void release(Mesh* mesh);
+
+		// THE LAST REFERENCE TO A DYNAMIC MESH MAY BE DROPPED ON ANY THREAD
+		void retire(std::unique_ptr<DynamicMeshBuffer> buffer);
+
+		std::array<Pool, VERTEX_FORMAT_COUNT> pools;
+
+		// CONTENT HASH -> MESH, FOR DEDUPLICATION
+		std::unordered_map<uint64_t, std::weak_ptr<Mesh>> meshes;
+
+		uint32_t nextMeshID = 1;
+
+		// OWNED BY THEIR MESHES UNTIL RETIRED
+		std::vector<DynamicMeshBuffer*> dynamicBuffers;
+		std::vector<std::unique_ptr<DynamicMeshBuffer>> retiredBuffers;
+		std::mutex dynamicBuffersMutex;
+	};
+}
@@ -1,6 +1,6 @@
 #include "physics_renderer.h"
 
-#include "renderer.h"
+#include "debug_draw.h"
 
 #include "math/Vector.h"
 
@@ -10,20 +10,26 @@ using namespace Neu;
 
 void PhysicsRenderer::DrawLine(RVec3Arg inFrom, RVec3Arg inTo, ColorArg inColor)
 {
-	Renderer::drawLine(
+	if (!debugDraw)
+		return;
+
+	debugDraw->addLine(
 		Vector3f(inFrom.GetX(), inFrom.GetY(), inFrom.GetZ()),
 		Vector3f(inTo.GetX(), inTo.GetY(), inTo.GetZ()),
-		Vector4f(inColor.r, inColor.g, inColor.b, inColor.a)
+		DebugDraw::packColor(inColor.r, inColor.g, inColor.b, inColor.a)
 	);
 }
 
 void PhysicsRenderer::DrawTriangle(RVec3Arg inV1, RVec3Arg inV2, RVec3Arg inV3, ColorArg inColor, ECastShadow inCastShadow)
 {
-	Renderer::drawTriangle(
+	if (!debugDraw)
+		return;
+
+	debugDraw->addTriangle(
 		Vector3f(inV1.GetX(), inV1.GetY(), inV1.GetZ()),
 		Vector3f(inV2.GetX(), inV2.GetY(), inV2.GetZ()),
 		Vector3f(inV3.GetX(), inV3.GetY(), inV3.GetZ()),
-		Vector4f(inColor.r, inColor.g, inColor.b, inColor.a)
+		DebugDraw::packColor(inColor.r, inColor.g, inColor.b, inColor.a)
 	);
 }
 
@@ -8,14 +8,22 @@ using namespace JPH;
 namespace Neu
 {
 
+	class DebugDraw;
+
 	class PhysicsRenderer : public DebugRendererSimple
 	{
 	public:
+		// PRIMITIVES ARE BATCHED INTO THIS DEBUG DRAW
+		void setDebugDraw(DebugDraw* debugDraw) { this->debugDraw = debugDraw; }
+
 		virtual void DrawLine(RVec3Arg inFrom, RVec3Arg inTo, ColorArg inColor) override;
 
 		virtual void DrawTriangle(RVec3Arg inV1, RVec3Arg inV2, RVec3Arg inV3, ColorArg inColor, ECastShadow inCastShadow) override;
 
 		virtual void DrawText3D(RVec3Arg inPosition, const string_view& inString, ColorArg inColor, float inHeight) override;
+
+	private:
+		DebugDraw* debugDraw = nullptr;
 	};
 
 }
\ No newline at end of file
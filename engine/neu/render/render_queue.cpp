@@ -0,0 +1,53 @@
+#include "render_queue.h"
+
+#include <algorithm>
+
+using namespace Neu;
+
+uint64_t RenderQueue::makeSortKey(uint32_t shaderID, uint32_t meshID, uint32_t materialID, float normalizedDepth)
+{
+	uint64_t depth = (uint64_t)(std::clamp(normalizedDepth, 0.0f, 1.0f) * 0xFFFF);
+
+	return ((uint64_t)(shaderID & 0xFFF) << 52)
+		| ((uint64_t)(meshID & 0xFFFFF) << 32)
+		| ((uint64_t)(materialID & 0xFFFF) << 16)
+		| depth;
+}
+
+void RenderQueue::sort()
+{
+	const size_t count = packets.size();
+
+	if (count < 2)
+		return;
+
+	scratch.resize(count);
+
+	for (int pass = 0; pass < 8; pass++)
+	{
+		const int shift = pass * 8;
+
+		size_t histogram[256] = {};
+
+		for (const DrawPacket& packet : packets)
+			histogram[(packet.sortKey >> shift) & 0xFF]++;
+
+		// EVERY KEY HAS THE SAME BYTE, THIS PASS WOULD NOT CHANGE THE ORDER
+		if (histogram[(packets[0].sortKey >> shift) & 0xFF] == count)
+			continue;
+
+		size_t offset = 0;
+
+		for (size_t& bucket : histogram)
+		{
+			size_t bucketCount = bucket;
+			bucket = offset;
+			offset += bucketCount;
+		}
+
+		for (const DrawPacket& packet : packets)
+			scratch[histogram[(packet.sortKey >> shift) & 0xFF]++] = packet;
+
+		packets.swap(scratch);
+	}
+}
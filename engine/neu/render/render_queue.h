@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "math/Matrix.h"
+#include "math/Vector.h"
+
+namespace Neu
+{
+	class Shader;
+	class Mesh;
+	struct MeshDrawRange;
+
+	/**
+	 * A single mesh instance to draw. Packets with equal shader and mesh end up
+	 * next to each other after sorting and are drawn as one instanced batch.
+	 */
+	struct DrawPacket
+	{
+		uint64_t sortKey;
+
+		Shader* shader;
+		Mesh* mesh;
+
+		// POINT INTO THE SNAPSHOT THAT IS DRAWN
+		const MeshDrawRange* drawRange;
+		const Matrix4x4f* modelMatrix;
+		Vector3f color;
+	};
+
+	/**
+	 * Collects the draw packets of a frame and orders them by sort key, so the
+	 * renderer can submit them with as few state changes as possible.
+	 *
+	 * Sort key layout (most significant bits first):
+	 *   [63..52] shader   (12 bits)
+	 *   [51..32] mesh     (20 bits)
+	 *   [31..16] material (16 bits)
+	 *   [15..0]  depth    (16 bits, front to back)
+	 */
+	class RenderQueue
+	{
+	public:
+		static uint64_t makeSortKey(uint32_t shaderID, uint32_t meshID, uint32_t materialID, float normalizedDepth);
+
+		void clear() { packets.clear(); }
+		void push(const DrawPacket& packet) { packets.push_back(packet); }
+
+		/**
+		 * LSD radix sort on the 64-bit keys, one byte per pass. Passes over
+		 * bytes that are the same for every packet are skipped.
+		 */
+		void sort();
+
+		const std::vector<DrawPacket>& getPackets() const { return packets; }
+		size_t size() const { return packets.size(); }
+
+	private:
+		std::vector<DrawPacket> packets;
+		std::vector<DrawPacket> scratch;
+	};
+}
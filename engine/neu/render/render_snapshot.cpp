@@ -0,0 +1,73 @@
+#include "render_snapshot.h"
+
+#include "components/component_manager.h"
+#include "components/light.h"
+#include "components/mesh.h"
+#include "components/rigid_body.h"
+#include "components/transform.h"
+#include "scene/scene.h"
+#include "utility/profiler.h"
+
+using namespace Neu;
+
+void RenderSnapshot::extract(Scene& scene)
+{
+	NEU_PROFILE_FUNCTION;
+
+	ComponentManager& componentManager = scene.getComponentManager();
+
+	camera = scene.getCamera();
+	backgroundColor = scene.getBackgroundColor();
+
+	// THE NODE ARRAY IS COPIED INTO THE STORAGE OF THE LAST COPY
+	spatialTree = scene.getTransformSystem().getSpatialTree();
+
+	////////////////////
+	// MESH INSTANCES //
+	////////////////////
+
+	instances.clear();
+	instanceIndices.assign(instanceIndices.size(), NO_INSTANCE);
+
+	componentManager.view<TransformComponent, MeshComponent>().each(
+		[&](Entity entity, TransformComponent& transform, MeshComponent& mesh)
+	{
+		// DYNAMIC MESHES ARE EMPTY UNTIL THEIR FIRST UPDATE
+		if (!mesh.mesh || !mesh.mesh->getBounds().isValid())
+			return;
+
+		if (entity >= instanceIndices.size())
+			instanceIndices.resize(entity + 1, NO_INSTANCE);
+
+		instanceIndices[entity] = (uint32_t)instances.size();
+
+		bool dynamic = mesh.mesh->isDynamic() || componentManager.hasComponent<RigidBodyComponent>(entity);
+
+		const AABB bounds = mesh.mesh->getBounds().transformed(transform.transform);
+
+		instances.push_back({ mesh.mesh, mesh.mesh->getDrawRange(), bounds, transform.transform, mesh.color, entity, transform.updatedFrame, dynamic });
+	});
+
+	////////////
+	// LIGHTS //
+	////////////
+
+	pointLights.clear();
+
+	componentManager.view<TransformComponent, LightComponent>().each(
+		[&](Entity, TransformComponent& transform, LightComponent& light)
+	{
+		const Vector3f position(transform.transform(0, 3), transform.transform(1, 3), transform.transform(2, 3));
+
+		pointLights.push_back({ position, light.radius, light.color, light.intensity });
+	});
+
+	hasDirectionalLight = false;
+
+	for (auto [entity, light] : componentManager.view<DirectionalLightComponent>())
+	{
+		directionalLight = { light.direction, light.color * light.intensity, light.castsShadows };
+		hasDirectionalLight = true;
+		break;
+	}
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "components/component_type.h"
+#include "components/mesh.h"
+#include "math/Matrix.h"
+#include "math/Vector.h"
+#include "scene/camera.h"
+#include "utility/aabb_tree.h"
+
+namespace Neu
+{
+	class Scene;
+
+	/**
+	 * Everything the renderer reads from one simulated frame, copied out of
+	 * the scene once the frame's systems have finished. The renderer only
+	 * draws snapshots, so the simulation can run the next frame on its own
+	 * thread while the GL thread draws this one; the application keeps two
+	 * of them and swaps after every frame.
+	 *
+	 * Extracting into a snapshot reuses the storage of its previous
+	 * contents, so steady-state frames do not allocate.
+	 */
+	class RenderSnapshot
+	{
+	public:
+		struct MeshInstance
+		{
+			// KEEPS THE MESH ALIVE WHILE THE SNAPSHOT IS DRAWN
+			std::shared_ptr<Mesh> mesh;
+
+			// COPIED FROM THE MESH, A DYNAMIC MESH MAY ALREADY HOLD THE NEXT
+			// FRAME'S GEOMETRY WHILE THIS ONE IS DRAWN
+			MeshDrawRange drawRange;
+			AABB bounds;  // WORLD SPACE
+
+			Matrix4x4f transform;
+			Vector3f color;
+
+			Entity entity;
+			uint32_t updatedFrame;
+
+			// MOVES EVERY FRAME (RIGID BODY OR DYNAMIC MESH), NEVER CACHED
+			bool dynamic;
+		};
+
+		struct PointLight
+		{
+			Vector3f position;
+			float radius;
+			Vector3f color;
+			float intensity;
+		};
+
+		struct DirectionalLight
+		{
+			Vector3f direction;
+			Vector3f color;  // COLOR * INTENSITY
+			bool castsShadows;
+		};
+
+		/**
+		 * Copies the render state of the scene. Must not overlap with a scene
+		 * update or with drawing this snapshot.
+		 */
+		void extract(Scene& scene);
+
+		const Camera& getCamera() const { return camera; }
+		const Vector3f& getBackgroundColor() const { return backgroundColor; }
+
+		/**
+		 * Copy of the scene's spatial tree. Its proxies belong to the entities
+		 * of the mesh instances, see getInstance().
+		 */
+		const DynamicAABBTree& getSpatialTree() const { return spatialTree; }
+
+		const std::vector<MeshInstance>& getInstances() const { return instances; }
+
+		// NULL IF THE ENTITY HAS NO MESH
+		const MeshInstance* getInstance(Entity entity) const
+		{
+			if (entity >= instanceIndices.size() || instanceIndices[entity] == NO_INSTANCE)
+				return nullptr;
+
+			return &instances[instanceIndices[entity]];
+		}
+
+		const std::vector<PointLight>& getPointLights() const { return pointLights; }
+
+		// THE FIRST DIRECTIONAL LIGHT OF THE SCENE, NULL WITHOUT ONE
+		const DirectionalLight* getDirectionalLight() const { return hasDirectionalLight ? &directionalLight : nullptr; }
+
+	private:
+		static constexpr uint32_t NO_INSTANCE = 0xFFFFFFFF;
+
+		Camera camera;
+		Vector3f backgroundColor;
+
+		DynamicAABBTree spatialTree;
+
+		std::vector<MeshInstance> instances;
+
+		// ENTITY -> INDEX INTO instances
+		std::vector<uint32_t> instanceIndices;
+
+		std::vector<PointLight> pointLights;
+
+		DirectionalLight directionalLight = {};
+		bool hasDirectionalLight = false;
+	};
+}
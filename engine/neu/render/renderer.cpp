@@ -1,145 +1,499 @@
 #include "renderer.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
 #include "core.h"
 
-#include "scene/scene.h"
-#include "scene/game_object.h"
+#include "scene/camera.h"
 
 #include "utility/profiler.h"
 #include "application.h"
 #include "shader_manager.h"
+#include "utility/thread_pool.h"
 
 #include "components/mesh.h"
-#include "components/transform.h"
+#include "render/debug_draw.h"
+#include "render/light_clusters.h"
+#include "render/render_snapshot.h"
+#include "render/shadow_cascades.h"
 
 using namespace Neu;
 
-void Renderer::renderScene(Scene* scene)
+Renderer::Renderer()
+{
+	glGenBuffers(1, &instanceVBO);
+
+	debugDraw = new DebugDraw();
+	lightClusters = new LightClusters();
+	shadowCascades = new ShadowCascades();
+}
+
+Renderer::~Renderer()
+{
+	glDeleteBuffers(1, &instanceVBO);
+
+	delete debugDraw;
+	delete lightClusters;
+	delete shadowCascades;
+}
+
+void Renderer::renderScene(const RenderSnapshot& snapshot)
 {
 	NEU_PROFILE_FUNCTION;
+	NEU_PROFILE_GPU(renderScene);
 
 	//PROFILE_START;
-	Vector3f backgroundColor = scene->getBackgroundColor();
+	const Vector3f& backgroundColor = snapshot.getBackgroundColor();
+
+	glClearColor(backgroundColor.x, backgroundColor.y, backgroundColor.z, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	statistics = RenderStatistics();
 
-	//glClearColor(backgroundColor.x, backgroundColor.y, backgroundColor.z, 1.0f);
-	//glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	const Camera& camera = snapshot.getCamera();
 
 	ShaderManager* shaderManager = Application::getInstance()->getShaderManager();
 
-	for (GameObject* gameObject : scene->getGameObjects())
-	{
-		if (gameObject->hasComponent<TransformComponent>() 
-			&& gameObject->hasComponent<MeshComponent>())
-		{
-			auto& transform = gameObject->getComponent<TransformComponent>();
-			auto& mesh = gameObject->getComponent<MeshComponent>();
+	shaderManager->updateUniformBuffer("camera", 0, sizeof(Matrix4x4f), camera.getViewMatrix().ptr());
+	shaderManager->updateUniformBuffer("camera", sizeof(Matrix4x4f), sizeof(Matrix4x4f), camera.getProjectionMatrix());
 
-			// TODO: DEFINE WHICH SHADER TO USE
-			Shader* shader = shaderManager->getShader("simple");
+	collectLights(snapshot);
 
-			shader->use();
-			shader->setMatrix4x4f("model_matrix", transform.transform);
-			shader->setVector3f("color", gameObject->color);
+	if (castsShadows)
+		renderShadows(snapshot);
 
-			glBindVertexArray(mesh.getVAO());
-			glDrawElements(GL_TRIANGLES, (GLsizei)(mesh.getFaceCount() * 3), GL_UNSIGNED_INT, 0);
-			glBindVertexArray(0);
+	collectDrawPackets(snapshot);
+	renderQueue.sort();
 
-		}
+	{
+		NEU_PROFILE_GPU(mainPass);
+		submitDrawPackets(renderQueue);
 	}
 
-	// RENDER PHYSICS (MOVE DEBUG RENDERER HERE)
+	// PHYSICS LINES ARE ADDED BY THE APPLICATION WHILE THE SIMULATION IS IDLE
+	{
+		NEU_PROFILE_GPU(debugDraw);
+		debugDraw->flush();
+	}
 
 	//PROFILE_STOP;
 }
 
-void Renderer::toggleWireframe()
+void Renderer::collectLights(const RenderSnapshot& snapshot)
+{
+	NEU_PROFILE_FUNCTION;
+
+	lightClusters->clear();
+
+	for (const RenderSnapshot::PointLight& light : snapshot.getPointLights())
+		lightClusters->addLight(light.position, light.radius, light.color, light.intensity);
+
+	lightClusters->update(snapshot.getCamera());
+
+	ShaderManager* shaderManager = Application::getInstance()->getShaderManager();
+
+	shaderManager->updateUniformBuffer("clusters", 0, sizeof(ClusterParameters), &lightClusters->getParameters());
+	lightClusters->bindTextures();
+
+	///////////////////////
+	// DIRECTIONAL LIGHT //
+	///////////////////////
+
+	const RenderSnapshot::DirectionalLight* light = snapshot.getDirectionalLight();
+
+	hasDirectionalLight = light != nullptr;
+	castsShadows = light && light->castsShadows;
+
+	if (hasDirectionalLight)
+	{
+		shadowCascades->update(snapshot.getCamera(), light->direction, light->color, light->castsShadows);
+		shaderManager->updateUniformBuffer("directional_light", 0, sizeof(DirectionalLightBuffer), &shadowCascades->getLightBuffer());
+	}
+
+	statistics.lights = (unsigned int)lightClusters->getLightCount();
+	statistics.clusterLightIndices = (unsigned int)lightClusters->getLightIndexCount();
+}
+
+/**
+ * Mixes the identity of a static caster into 64 bits (splitmix64 finalizer),
+ * so the hashes of all casters can simply be added up.
+ */
+static uint64_t hashCaster(Entity entity, uint32_t updatedFrame, uint32_t meshID)
+{
+	uint64_t hash = ((uint64_t)entity << 32 | updatedFrame) ^ ((uint64_t)meshID * 0x9E3779B97F4A7C15ull);
+
+	hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+	hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+	return hash ^ (hash >> 31);
+}
+
+void Renderer::renderShadows(const RenderSnapshot& snapshot)
 {
+	NEU_PROFILE_FUNCTION;
+	NEU_PROFILE_GPU(renderShadows);
+
+	ShaderVariant variant;
+	variant.features = SHADER_FEATURE_INSTANCED;
+
+	Shader* depthShader = Application::getInstance()->getShaderManager()->getShader("depth", variant);
+
+	const DynamicAABBTree& spatialTree = snapshot.getSpatialTree();
+
+	// CASTERS ARE ALWAYS FILLED
 	if (wireframeMode)
 		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-	else
+
+	shadowCascades->begin();
+
+	for (int cascade = 0; cascade < SHADOW_CASCADE_COUNT; cascade++)
+	{
+		const Frustum& frustum = shadowCascades->getCasterFrustum(cascade);
+
+		staticShadowQueue.clear();
+		dynamicShadowQueue.clear();
+
+		// ORDER INDEPENDENT, THE TREE MAY VISIT THE SAME CASTERS IN ANOTHER
+		// ORDER AFTER DYNAMIC PROXIES MOVED
+		uint64_t staticCasterHash = 0;
+
+		spatialTree.query(frustum, [&](Entity entity)
+		{
+			const RenderSnapshot::MeshInstance* instance = snapshot.getInstance(entity);
+
+			// PROXIES OF MESHES REMOVED SINCE THE LAST TRANSFORM UPDATE
+			if (!instance)
+				return true;
+
+			if (!frustum.intersects(instance->bounds))
+				return true;
+
+			uint64_t sortKey = RenderQueue::makeSortKey(depthShader->getID(), instance->mesh->getID(), 0, 0.0f);
+			DrawPacket packet = { sortKey, depthShader, instance->mesh.get(), &instance->drawRange, &instance->transform, instance->color };
+
+			// RIGID BODIES AND DYNAMIC MESHES MOVE EVERY FRAME, EVERYTHING
+			// ELSE GOES INTO THE CACHE
+			if (instance->dynamic)
+			{
+				dynamicShadowQueue.push(packet);
+				return true;
+			}
+
+			staticShadowQueue.push(packet);
+
+			// A MOVED STATIC CASTER HAS A NEW updatedFrame
+			staticCasterHash += hashCaster(entity, instance->updatedFrame, instance->mesh->getID());
+
+			return true;
+		});
+
+		shadowPassCommands.clear();
+		shadowPassCommands.bindShader(depthShader);
+		shadowPassCommands.setUniform("light_space_matrix", shadowCascades->getMatrix(cascade));
+
+		if (shadowCascades->beginStaticCasters(cascade, staticCasterHash))
+		{
+			staticShadowQueue.sort();
+			submitDrawPackets(staticShadowQueue, &shadowPassCommands);
+			statistics.shadowCacheUpdates++;
+		}
+
+		if (shadowCascades->beginDynamicCasters(cascade, dynamicShadowQueue.size() > 0))
+		{
+			dynamicShadowQueue.sort();
+			submitDrawPackets(dynamicShadowQueue, &shadowPassCommands);
+			statistics.shadowPasses++;
+		}
+	}
+
+	shadowCascades->end();
+	shadowCascades->bindTexture();
+
+	if (wireframeMode)
 		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+}
 
-	wireframeMode = !wireframeMode;
+void Renderer::collectDrawPackets(const RenderSnapshot& snapshot)
+{
+	NEU_PROFILE_FUNCTION;
+
+	ShaderManager* shaderManager = Application::getInstance()->getShaderManager();
+
+	// TODO: DEFINE WHICH SHADER TO USE
+	ShaderVariant variant;
+	variant.features = SHADER_FEATURE_INSTANCED;
+
+	Shader* shader;
+
+	// UNLIT WITHOUT LIGHTS
+	if (lightClusters->getLightCount() > 0 || hasDirectionalLight)
+	{
+		variant.features |= SHADER_FEATURE_CLUSTERED;
+
+		if (hasDirectionalLight)
+			variant.features |= SHADER_FEATURE_SHADOWS;
+
+		shader = shaderManager->getShader("light", variant);
+	}
+	else
+	{
+		shader = shaderManager->getShader("simple", variant);
+	}
+
+	const Camera& camera = snapshot.getCamera();
+
+	const Vector3f cameraPosition = camera.getPosition();
+	const float inverseFarPlane = 1.0f / camera.getFarPlane();
+
+	const Frustum frustum = Frustum::fromMatrix(Matrix4x4f(camera.getProjectionMatrix()) * camera.getViewMatrix());
+
+	renderQueue.clear();
+
+	const DynamicAABBTree& spatialTree = snapshot.getSpatialTree();
+
+	// ONLY SUBTREES THAT INTERSECT THE FRUSTUM ARE VISITED
+	spatialTree.query(frustum, [&](Entity entity)
+	{
+		const RenderSnapshot::MeshInstance* instance = snapshot.getInstance(entity);
+
+		// PROXIES OF MESHES REMOVED SINCE THE LAST TRANSFORM UPDATE
+		if (!instance)
+			return true;
+
+		// THE TREE HOLDS FAT BOXES, TEST THE EXACT BOUNDS
+		if (!frustum.intersects(instance->bounds))
+			return true;
+
+		statistics.visibleObjects++;
+
+		Vector3f offset = Vector3f(instance->transform(0, 3), instance->transform(1, 3), instance->transform(2, 3)) - cameraPosition;
+		float depth = sqrtf(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z) * inverseFarPlane;
+
+		// NO MATERIALS YET, EVERYTHING USES MATERIAL 0
+		uint64_t sortKey = RenderQueue::makeSortKey(shader->getID(), instance->mesh->getID(), 0, depth);
+
+		renderQueue.push({ sortKey, shader, instance->mesh.get(), &instance->drawRange, &instance->transform, instance->color });
+
+		return true;
+	});
+
+	statistics.culledObjects = (unsigned int)spatialTree.getProxyCount() - statistics.visibleObjects;
+
+	statistics.packets = (unsigned int)renderQueue.size();
 }
 
-void Renderer::drawLine(Vector3f start, Vector3f end, Vector4f color)
+void Renderer::submitDrawPackets(const RenderQueue& queue, const RenderCommandBuffer* passCommands)
 {
-	//Logger::debug("RENDERING LINE FROM (%f, %f, %f) TO (%f, %f, %f)\n", start.x, start.y, start.z, end.x, end.y, end.z);
+	NEU_PROFILE_FUNCTION;
+
+	const std::vector<DrawPacket>& packets = queue.getPackets();
 
-	unsigned int VAO;
-	unsigned int VBO;
+	ThreadPool* threadPool = Application::getInstance()->getThreadPool();
 
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
+	///////////////////////
+	// SPLIT INTO RANGES //
+	///////////////////////
 
-	float vertices[] = {
-		start.x, start.y, start.z,
-		end.x, end.y, end.z
-	};
+	const size_t maxRanges = std::min((size_t)threadPool->getWorkerCount() + 1, packets.size() / MIN_PACKETS_PER_RECORDING + 1);
+	const size_t rangeSize = packets.size() / maxRanges + 1;
 
-	glBindVertexArray(VAO);
+	recordingRanges.clear();
+	recordingRanges.push_back(0);
 
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_STATIC_DRAW);
+	while (recordingRanges.back() < packets.size())
+	{
+		size_t end = std::min(recordingRanges.back() + rangeSize, packets.size());
 
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (GLvoid*)0);
-	glEnableVertexAttribArray(0);
+		// NEVER SPLIT A BATCH, IT WOULD COST AN EXTRA DRAW CALL
+		while (end < packets.size() && packets[end].shader == packets[end - 1].shader && packets[end].mesh == packets[end - 1].mesh)
+			end++;
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+		recordingRanges.push_back(end);
+	}
+
+	const size_t rangeCount = recordingRanges.size() - 1;
+
+	if (commandBuffers.size() < rangeCount)
+		commandBuffers.resize(rangeCount);
+
+	////////////
+	// RECORD //
+	////////////
+
+	instanceData.resize(packets.size());
+
+	threadPool->parallelFor(rangeCount, [&](size_t range)
+	{
+		commandBuffers[range].clear();
+		recordDrawPackets(packets, recordingRanges[range], recordingRanges[range + 1], commandBuffers[range]);
+	});
+
+	//////////////////////
+	// UPLOAD INSTANCES //
+	//////////////////////
 
-	Shader* lineShader = Application::getInstance()->getShaderManager()->getShader("line");
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
 
-	lineShader->use();
-	lineShader->setVector3f("color", color);
+	// ORPHAN LAST FRAME'S STORAGE SO THE UPLOAD DOES NOT WAIT ON THE GPU
+	glBufferData(GL_ARRAY_BUFFER, instanceData.size() * sizeof(InstanceData), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, instanceData.size() * sizeof(InstanceData), instanceData.data());
+
+	////////////
+	// REPLAY //
+	////////////
+
+	replayOrder.clear();
+
+	if (passCommands)
+		replayOrder.push_back(passCommands);
+
+	for (size_t range = 0; range < rangeCount; range++)
+		replayOrder.push_back(&commandBuffers[range]);
+
+	executeCommands(replayOrder);
 
-	glBindVertexArray(VAO);
-	glDrawArrays(GL_LINES, 0, 2);
 	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Renderer::recordDrawPackets(const std::vector<DrawPacket>& packets, size_t begin, size_t end, RenderCommandBuffer& commands)
+{
+	Shader* shader = nullptr;
+	Mesh* geometry = nullptr;
+
+	for (size_t first = begin; first < end;)
+	{
+		// PACKETS WITH THE SAME SHADER AND MESH ARE ADJACENT AFTER SORTING
+		size_t last = first + 1;
+
+		while (last < end && packets[last].shader == packets[first].shader && packets[last].mesh == packets[first].mesh)
+			last++;
+
+		if (packets[first].shader != shader)
+		{
+			shader = packets[first].shader;
+			commands.bindShader(shader);
+		}
+
+		Mesh* mesh = packets[first].mesh;
 
-	// CLEAR RESOURCES
-	glDeleteVertexArrays(1, &VAO);
-	glDeleteBuffers(1, &VBO);
+		// MESHES OF THE SAME ARENA SHARE THEIR GEOMETRY, REPLAY SKIPS THE BIND
+		if (mesh != geometry)
+		{
+			geometry = mesh;
+			commands.bindGeometry(mesh);
+		}
+
+		for (size_t i = first; i < last; i++)
+		{
+			instanceData[i].modelMatrix = *packets[i].modelMatrix;
+			instanceData[i].color = packets[i].color;
+		}
+
+		// EVERY INSTANCE OF A MESH HAS THE SAME RANGE
+		commands.drawInstanced(packets[first].drawRange, (uint32_t)first, (uint32_t)(last - first));
+
+		first = last;
+	}
 }
 
-void Renderer::drawTriangle(Vector3f v1, Vector3f v2, Vector3f v3, Vector4f color)
+void Renderer::executeCommands(const std::vector<const RenderCommandBuffer*>& buffers)
 {
-	//Logger::debug("RENDERING TRIANGLE\n");
+	NEU_PROFILE_FUNCTION;
 
-	unsigned int VAO;
-	unsigned int VBO;
+	Shader* boundShader = nullptr;
+	unsigned int boundVAO = 0;
 
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
+	for (const RenderCommandBuffer* buffer : buffers)
+	{
+		for (const RenderCommand& command : buffer->getCommands())
+		{
+			switch (command.type)
+			{
+			case RenderCommandType::BIND_SHADER:
+				if (command.shader != boundShader)
+				{
+					boundShader = command.shader;
+					boundShader->use();
+					LightClusters::setSamplers(*boundShader);
+					ShadowCascades::setSamplers(*boundShader);
+					statistics.shaderChanges++;
+				}
+				break;
+
+			case RenderCommandType::BIND_GEOMETRY:
+				if (command.mesh->getVAO() != boundVAO)
+				{
+					boundVAO = command.mesh->getVAO();
+					glBindVertexArray(boundVAO);
+					statistics.vertexArrayChanges++;
+				}
+				break;
+
+			case RenderCommandType::SET_UNIFORM_MATRIX:
+			{
+				HashedName name;
+				name.hash = command.uniformMatrix.name;
+				boundShader->setMatrix4x4f(name, buffer->getMatrix(command.uniformMatrix.matrix));
+				break;
+			}
+
+			case RenderCommandType::DRAW_INSTANCED:
+			{
+				const MeshDrawRange* range = command.draw.range;
+
+				bindInstanceAttributes(command.draw.firstInstance);
+
+				// MESHES SHARE THE ARENA BUFFERS, OFFSET INTO THEM
+				glDrawElementsInstancedBaseVertex(GL_TRIANGLES, (GLsizei)range->indexCount, GL_UNSIGNED_INT,
+					(void*)(range->firstIndex * sizeof(uint32_t)), (GLsizei)command.draw.instanceCount, (GLint)range->baseVertex);
+				statistics.drawCalls++;
+				break;
+			}
+			}
+		}
 
-	float vertices[] = { 
-		v1.x, v1.y, v1.z,
-		v2.x, v2.y, v2.z,
-		v3.x, v3.y, v3.z
-	};
+		statistics.commands += (unsigned int)buffer->size();
+	}
 
-	glBindVertexArray(VAO);
+	statistics.commandBuffers += (unsigned int)buffers.size();
+}
 
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_STATIC_DRAW);
+void Renderer::bindInstanceAttributes(size_t firstInstance)
+{
+	const size_t baseOffset = firstInstance * sizeof(InstanceData);
 
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (GLvoid*)0);
-	glEnableVertexAttribArray(0);
+	// ONE VEC4 ATTRIBUTE PER MATRIX COLUMN
+	for (unsigned int column = 0; column < 4; column++)
+	{
+		glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+			(void*)(baseOffset + offsetof(InstanceData, modelMatrix) + column * sizeof(Vector4f)));
+		glEnableVertexAttribArray(3 + column);
+		glVertexAttribDivisor(3 + column, 1);
+	}
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	glVertexAttribPointer(7, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(baseOffset + offsetof(InstanceData, color)));
+	glEnableVertexAttribArray(7);
+	glVertexAttribDivisor(7, 1);
+}
 
-	Shader* lineShader = Application::getInstance()->getShaderManager()->getShader("line");
+void Renderer::toggleWireframe()
+{
+	if (wireframeMode)
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	else
+		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
-	lineShader->use();
-	lineShader->setVector3f("color", color);
+	wireframeMode = !wireframeMode;
+}
 
-	glBindVertexArray(VAO);
-	glDrawArrays(GL_TRIANGLES, 0, 3);
-	glBindVertexArray(0);
+void Renderer::drawLine(Vector3f start, Vector3f end, Vector4f color)
+{
+	Application::getInstance()->getRenderer()->getDebugDraw()->addLine(start, end, DebugDraw::packColor(color));
+}
 
-	// CLEAR RESOURCES
-	glDeleteVertexArrays(1, &VAO);
-	glDeleteBuffers(1, &VBO);
-}
\ No newline at end of file
+void Renderer::drawTriangle(Vector3f v1, Vector3f v2, Vector3f v3, Vector4f color)
+{
+	Application::getInstance()->getRenderer()->getDebugDraw()->addTriangle(v1, v2, v3, DebugDraw::packColor(color));
+}
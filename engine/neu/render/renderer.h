@@ -1,29 +1,156 @@
 #pragma once
 
+#include <vector>
+
+#include "math/Matrix.h"
 #include "math/Vector.h"
+#include "render/command_buffer.h"
+#include "render/render_queue.h"
 
 namespace Neu
 {
-	class Scene;
+	class RenderSnapshot;
+	class Shader;
+	class Mesh;
+	class DebugDraw;
+	class LightClusters;
+	class ShadowCascades;
+
+	// PER-INSTANCE VERTEX ATTRIBUTES (LOCATIONS 3 TO 7 OF SIMPLE_INSTANCED.VERT)
+	struct InstanceData
+	{
+		Matrix4x4f modelMatrix;
+		Vector3f color;
+	};
+
+	// STATE CHANGES AND DRAW CALLS OF THE LAST FRAME
+	struct RenderStatistics
+	{
+		unsigned int visibleObjects = 0;
+		unsigned int culledObjects = 0;
+
+		unsigned int packets = 0;
+		unsigned int drawCalls = 0;
+		unsigned int shaderChanges = 0;
+		unsigned int vertexArrayChanges = 0;
+
+		unsigned int lights = 0;
+		unsigned int clusterLightIndices = 0;
+
+		// CASCADES WHOSE DYNAMIC CASTERS WERE DRAWN, AND STATIC CACHE REDRAWS
+		unsigned int shadowPasses = 0;
+		unsigned int shadowCacheUpdates = 0;
+
+		// RECORDED IN PARALLEL, AND THE COMMANDS REPLAYED FROM THEM
+		unsigned int commandBuffers = 0;
+		unsigned int commands = 0;
+	};
 	
 	// ACTS SIMILARLY TO A SYSTEM, IDEALLY CONTAINS NO STATE
 	class Renderer
 	{
 	public:
-		void renderScene(Scene* scene);
+		Renderer();
+		~Renderer();
+
+		/**
+		 * Draws a snapshot of the scene. Only reads the snapshot, never the
+		 * scene itself, so the next frame can be simulated meanwhile.
+		 */
+		void renderScene(const RenderSnapshot& snapshot);
 
 		void toggleWireframe();
 		//void viewNormals();
 		//void viewDiffuse();
 		//void toggleShadows();
 
-		// TO SUPPORT PHYSICS RENDERER
+		// BATCHED, DRAWN AT THE END OF THE FRAME (COLOR COMPONENTS IN [0, 1])
 		static void drawLine(Vector3f start, Vector3f end, Vector4f color);
 		static void drawTriangle(Vector3f v1, Vector3f v2, Vector3f v3, Vector4f color);
 
+		const RenderStatistics& getStatistics() const { return statistics; }
+		DebugDraw* getDebugDraw() const { return debugDraw; }
+
 	protected:
+		/**
+		 * Assigns the point lights of the snapshot to the clusters of the
+		 * camera frustum. Also fits the shadow cascades to the directional
+		 * light.
+		 */
+		void collectLights(const RenderSnapshot& snapshot);
+
+		/**
+		 * Draws the casters of every cascade into the shadow map. Static
+		 * casters are only redrawn when their cascade's cache is invalid.
+		 */
+		void renderShadows(const RenderSnapshot& snapshot);
+
+		/**
+		 * Fills the render queue with one packet per mesh instance whose world
+		 * bounds intersect the camera frustum. Candidates come from the
+		 * snapshot's spatial tree, so culled subtrees are skipped as a whole.
+		 */
+		void collectDrawPackets(const RenderSnapshot& snapshot);
+
+		/**
+		 * Draws a sorted render queue. The queue is split into ranges at batch
+		 * boundaries, which are recorded into command buffers (and have their
+		 * instance data filled) on the thread pool, then uploaded and replayed
+		 * in order, after passCommands (e.g. the shader and uniforms of a
+		 * pass) if given.
+		 */
+		void submitDrawPackets(const RenderQueue& queue, const RenderCommandBuffer* passCommands = nullptr);
+
+		/**
+		 * Records the packets [begin, end) of a sorted queue: binds when the
+		 * shader or mesh changes and one instanced draw per batch. Writes the
+		 * same range of instanceData, so ranges can be recorded concurrently.
+		 */
+		void recordDrawPackets(const std::vector<DrawPacket>& packets, size_t begin, size_t end, RenderCommandBuffer& commands);
+
+		/**
+		 * Replays command buffers in order on the GL thread, skipping shader
+		 * and vertex array binds that do not change the bound state. Draws
+		 * read their instances from instanceVBO.
+		 */
+		void executeCommands(const std::vector<const RenderCommandBuffer*>& buffers);
+
+		/**
+		 * Points the instance attributes of the bound VAO at the instances of
+		 * a batch, starting at firstInstance in the instance buffer.
+		 */
+		void bindInstanceAttributes(size_t firstInstance);
+
+		// RANGES SMALLER THAN THIS ARE NOT WORTH A TASK
+		static constexpr size_t MIN_PACKETS_PER_RECORDING = 256;
+
 		bool wireframeMode = false;
 
+		// REUSED EVERY FRAME TO AVOID REALLOCATION
+		RenderQueue renderQueue;
+		RenderQueue staticShadowQueue;
+		RenderQueue dynamicShadowQueue;
+		std::vector<InstanceData> instanceData;
+		std::vector<RenderCommandBuffer> commandBuffers;
+		std::vector<size_t> recordingRanges;
+		std::vector<const RenderCommandBuffer*> replayOrder;
+
+		// SHADER AND UNIFORMS OF THE CURRENT SHADOW CASCADE
+		RenderCommandBuffer shadowPassCommands;
+
+		RenderStatistics statistics;
+
+		unsigned int instanceVBO;
+
+		DebugDraw* debugDraw;
+
+		LightClusters* lightClusters;
+		ShadowCascades* shadowCascades;
+
+		// SET BY collectLights
+		bool hasDirectionalLight = false;
+		bool castsShadows = false;
+
 		// OTHER SETTINGS LIKE SSAO, BLOOM, DOF (EVENTUALLY)
 		// HONESTLY MOVE THESE TO CAMERA COMPONENT
 	};
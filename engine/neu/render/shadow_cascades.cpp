@@ -0,0 +1,265 @@
+#include "shadow_cascades.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "core.h"
+#include "scene/camera.h"
+#include "shader.h"
+
+using namespace Neu;
+
+// BLEND BETWEEN LOGARITHMIC (1) AND UNIFORM (0) SPLITS
+static constexpr float SPLIT_LAMBDA = 0.75f;
+
+// HOW FAR THE CAMERA CAN MOVE BEFORE A CASCADE HAS TO FOLLOW, AS A FRACTION
+// OF ITS RADIUS. LARGER VALUES REDRAW THE CACHE LESS OFTEN BUT SPREAD THE
+// TEXELS OVER A LARGER AREA
+static constexpr float CASCADE_MARGIN = 0.25f;
+
+ShadowCascades::ShadowCascades()
+{
+	glGenTextures(1, &shadowTexture);
+	glGenTextures(1, &cacheTexture);
+
+	for (unsigned int texture : { shadowTexture, cacheTexture })
+	{
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, SHADOW_CASCADE_COUNT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+
+	// THE SHADOW MAP IS SAMPLED WITH DEPTH COMPARISON, SO LINEAR FILTERING
+	// GIVES 2X2 PCF FOR FREE. OUTSIDE THE MAP EVERYTHING IS LIT
+	const float borderColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, shadowTexture);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	// DEPTH ONLY FRAMEBUFFERS, THE LAYER IS ATTACHED PER CASCADE
+	glGenFramebuffers(1, &framebuffer);
+	glGenFramebuffers(1, &cacheFramebuffer);
+
+	for (unsigned int target : { framebuffer, cacheFramebuffer })
+	{
+		attachLayer(target, target == framebuffer ? shadowTexture : cacheTexture, 0);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			Logger::error("Shadow map framebuffer is incomplete\n");
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+ShadowCascades::~ShadowCascades()
+{
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteFramebuffers(1, &cacheFramebuffer);
+
+	glDeleteTextures(1, &shadowTexture);
+	glDeleteTextures(1, &cacheTexture);
+}
+
+void ShadowCascades::update(const Camera& camera, const Vector3f& direction, const Vector3f& color, bool castsShadows)
+{
+	const Vector3f forward = normalize(direction);
+
+	lightBuffer.direction[0] = -forward.x;
+	lightBuffer.direction[1] = -forward.y;
+	lightBuffer.direction[2] = -forward.z;
+
+	lightBuffer.color[0] = color.x;
+	lightBuffer.color[1] = color.y;
+	lightBuffer.color[2] = color.z;
+
+	// EVERY FRAGMENT LIES BEYOND THE LAST SPLIT, SO NOTHING IS SHADOWED
+	if (!castsShadows)
+	{
+		std::fill(std::begin(lightBuffer.cascadeSplits), std::end(lightBuffer.cascadeSplits), 0.0f);
+		return;
+	}
+
+	// A ROTATED LIGHT INVALIDATES EVERY CACHE
+	if (!(forward == lightDirection))
+	{
+		lightDirection = forward;
+
+		for (Cascade& cascade : cascades)
+			cascade.cacheValid = false;
+	}
+
+	/////////////////
+	// LIGHT SPACE //
+	/////////////////
+
+	const Vector3f worldUp = std::fabs(forward.y) > 0.99f ? Vector3f(1.0f, 0.0f, 0.0f) : Vector3f(0.0f, 1.0f, 0.0f);
+	const Vector3f right = normalize(cross(forward, worldUp));
+	const Vector3f up = cross(right, forward);
+
+	////////////
+	// SPLITS //
+	////////////
+
+	const float* projection = camera.getProjectionMatrix();
+	const Matrix4x4f inverseView = inverse(camera.getViewMatrix());
+
+	const float nearPlane = camera.getNearPlane();
+	const float farPlane = camera.getFarPlane();
+
+	// SQUARED DISTANCE FROM THE VIEW AXIS TO A FRUSTUM CORNER AT DEPTH 1
+	const float cornerScale = 1.0f / (projection[0] * projection[0]) + 1.0f / (projection[5] * projection[5]);
+
+	float splitNear = nearPlane;
+
+	for (int i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		Cascade& cascade = cascades[i];
+
+		const float fraction = (float)(i + 1) / SHADOW_CASCADE_COUNT;
+		const float splitFar = SPLIT_LAMBDA * nearPlane * std::pow(farPlane / nearPlane, fraction) +
+			(1.0f - SPLIT_LAMBDA) * (nearPlane + (farPlane - nearPlane) * fraction);
+
+		// BOUNDING SPHERE OF THE SPLIT. IT ONLY DEPENDS ON THE PROJECTION, SO
+		// ITS SIZE DOES NOT CHANGE WHEN THE CAMERA ROTATES
+		const float centerDepth = std::min((splitNear + splitFar) * (1.0f + cornerScale) * 0.5f, splitFar);
+		float radius = std::max(
+			std::sqrt((centerDepth - splitNear) * (centerDepth - splitNear) + splitNear * splitNear * cornerScale),
+			std::sqrt((splitFar - centerDepth) * (splitFar - centerDepth) + splitFar * splitFar * cornerScale));
+
+		// ROUND UP SO FLOAT NOISE DOES NOT CHANGE THE PROJECTION
+		radius = std::ceil(radius * 16.0f) / 16.0f;
+
+		const float extent = radius * (1.0f + CASCADE_MARGIN);
+		const float texelSize = 2.0f * extent / SHADOW_MAP_SIZE;
+
+		// MOVE IN WHOLE TEXELS (NO SHIMMERING) AND AT MOST HALF A STEP AWAY
+		// FROM THE SPLIT, WHICH THE MARGIN COVERS
+		const float step = texelSize * std::max(1.0f, std::floor(2.0f * radius * CASCADE_MARGIN / texelSize));
+
+		const Vector3f worldCenter = inverseView * Vector3f(0.0f, 0.0f, -centerDepth);
+
+		auto snap = [step](float value) { return std::floor(value / step + 0.5f) * step; };
+
+		const Vector3f center(snap(dot(worldCenter, right)), snap(dot(worldCenter, up)), snap(dot(worldCenter, forward)));
+
+		if (!(center == cascade.center) || extent != cascade.extent)
+		{
+			cascade.center = center;
+			cascade.extent = extent;
+			cascade.cacheValid = false;
+		}
+
+		// ORTHOGRAPHIC PROJECTION OF THE CUBE AROUND THE CENTER. DEPTH
+		// INCREASES AWAY FROM THE LIGHT
+		const float scale = 1.0f / extent;
+
+		Matrix4x4f& matrix = lightBuffer.cascadeMatrices[i];
+
+		matrix = Matrix4x4f(
+			right.x * scale, right.y * scale, right.z * scale, -center.x * scale,
+			up.x * scale, up.y * scale, up.z * scale, -center.y * scale,
+			forward.x * scale, forward.y * scale, forward.z * scale, -center.z * scale,
+			0.0f, 0.0f, 0.0f, 1.0f);
+
+		cascade.casterFrustum = Frustum::fromMatrix(matrix);
+
+		// DEPTH CLAMPING FLATTENS CASTERS IN FRONT OF THE NEAR PLANE ONTO IT,
+		// SO THEY ARE NOT CULLED
+		cascade.casterFrustum.planes[Frustum::NEAR_PLANE] = Vector4f(0.0f, 0.0f, 0.0f, 1.0f);
+
+		lightBuffer.cascadeSplits[i] = splitFar;
+		lightBuffer.cascadeTexelSizes[i] = texelSize;
+
+		splitNear = splitFar;
+	}
+}
+
+/////////////////
+// SHADOW PASS //
+/////////////////
+
+void ShadowCascades::begin()
+{
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glViewport(0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
+
+	glEnable(GL_DEPTH_CLAMP);
+
+	// SLOPE SCALED BIAS AGAINST SHADOW ACNE
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(1.5f, 2.0f);
+}
+
+void ShadowCascades::end()
+{
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glDisable(GL_DEPTH_CLAMP);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+bool ShadowCascades::beginStaticCasters(int index, uint64_t staticCasterHash)
+{
+	Cascade& cascade = cascades[index];
+
+	if (cascade.cacheValid && cascade.cacheHash == staticCasterHash)
+		return false;
+
+	cascade.cacheValid = true;
+	cascade.cacheHash = staticCasterHash;
+	cascade.holdsCache = false;
+
+	attachLayer(cacheFramebuffer, cacheTexture, index);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	return true;
+}
+
+bool ShadowCascades::beginDynamicCasters(int index, bool hasDynamicCasters)
+{
+	Cascade& cascade = cascades[index];
+
+	// NOTHING MOVED IN OR OUT SINCE THE LAST COPY
+	if (cascade.holdsCache && !hasDynamicCasters)
+		return false;
+
+	attachLayer(cacheFramebuffer, cacheTexture, index);
+	attachLayer(framebuffer, shadowTexture, index);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, cacheFramebuffer);
+	glBlitFramebuffer(0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, 0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+	cascade.holdsCache = !hasDynamicCasters;
+
+	return hasDynamicCasters;
+}
+
+void ShadowCascades::attachLayer(unsigned int target, unsigned int texture, int layer) const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, target);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0, layer);
+}
+
+void ShadowCascades::bindTexture() const
+{
+	glActiveTexture(GL_TEXTURE0 + SHADOW_MAP_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, shadowTexture);
+}
+
+void ShadowCascades::setSamplers(Shader& shader)
+{
+	shader.setInteger("shadow_map", SHADOW_MAP_TEXTURE_UNIT);
+}
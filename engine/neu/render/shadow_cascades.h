@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+
+#include "math/Matrix.h"
+#include "math/Vector.h"
+#include "utility/bounds.h"
+
+// MUST MATCH THE SIZE OF THE CASCADE ARRAYS IN LIGHT.FRAG
+#define SHADOW_CASCADE_COUNT 4
+#define SHADOW_MAP_SIZE 1024
+
+// UNIT 0 IS RESERVED FOR THE SHADOW MAP (THE CLUSTER TEXTURES START AT 1)
+#define SHADOW_MAP_TEXTURE_UNIT 0
+
+namespace Neu
+{
+	class Camera;
+	class Shader;
+
+	/**
+	 * Std140 layout of the "directional_light" uniform block in light.frag.
+	 */
+	struct DirectionalLightBuffer
+	{
+		// WORLD TO SHADOW MAP CLIP SPACE
+		Matrix4x4f cascadeMatrices[SHADOW_CASCADE_COUNT];
+
+		// VIEW DEPTH AT WHICH EACH CASCADE ENDS, ALL ZERO WITHOUT SHADOWS
+		float cascadeSplits[SHADOW_CASCADE_COUNT];
+
+		// WORLD SIZE OF A SHADOW MAP TEXEL, FOR THE NORMAL OFFSET
+		float cascadeTexelSizes[SHADOW_CASCADE_COUNT];
+
+		// TOWARDS THE LIGHT
+		float direction[4];
+
+		// COLOR * INTENSITY
+		float color[4];
+	};
+
+	/**
+	 * Cascaded shadow maps for one directional light. The camera frustum is
+	 * split by depth and every split gets its own layer of a depth texture
+	 * array, fitted to the bounding sphere of the split.
+	 *
+	 * Cascades only move in steps of half their radius, so between steps
+	 * their projection stays the same and the static casters can be cached:
+	 * each cascade keeps a second layer with only the static casters, which
+	 * is redrawn when the light, the projection or the static set changes.
+	 * Every frame the cache is copied into the shadow map and the dynamic
+	 * casters are drawn on top.
+	 *
+	 * Per frame: update(), then begin(), and for every cascade
+	 * beginStaticCasters() and beginDynamicCasters(), drawing the casters
+	 * with getMatrix() when they return true, and finally end().
+	 */
+	class ShadowCascades
+	{
+	public:
+		ShadowCascades();
+		~ShadowCascades();
+
+		ShadowCascades(const ShadowCascades&) = delete;
+		ShadowCascades& operator=(const ShadowCascades&) = delete;
+
+		/**
+		 * Fits the cascades to the camera and fills the uniform block.
+		 * direction is the way the light travels. Without castsShadows only
+		 * the direction and color are filled in.
+		 */
+		void update(const Camera& camera, const Vector3f& direction, const Vector3f& color, bool castsShadows);
+
+		/**
+		 * Sets up the depth-only state of the shadow pass. end() restores the
+		 * framebuffer and viewport.
+		 */
+		void begin();
+		void end();
+
+		/**
+		 * Returns true if the static casters have to be drawn into the
+		 * cache of the cascade, which is then bound and cleared.
+		 * staticCasterHash identifies the static casters inside the
+		 * cascade; any change to it redraws the cache.
+		 */
+		bool beginStaticCasters(int cascade, uint64_t staticCasterHash);
+
+		/**
+		 * Copies the cache of the cascade into the shadow map. Returns true
+		 * if the dynamic casters have to be drawn on top, false if the
+		 * cascade is unchanged since the last frame.
+		 */
+		bool beginDynamicCasters(int cascade, bool hasDynamicCasters);
+
+		void bindTexture() const;
+		static void setSamplers(Shader& shader);
+
+		const Matrix4x4f& getMatrix(int cascade) const { return lightBuffer.cascadeMatrices[cascade]; }
+
+		/**
+		 * Frustum of the cascade without its near plane, since casters
+		 * between the light and the cascade still throw shadows into it.
+		 */
+		const Frustum& getCasterFrustum(int cascade) const { return cascades[cascade].casterFrustum; }
+
+		// CONTENTS OF THE DIRECTIONAL_LIGHT UNIFORM BLOCK FOR THE LAST UPDATE
+		const DirectionalLightBuffer& getLightBuffer() const { return lightBuffer; }
+
+	private:
+		struct Cascade
+		{
+			Frustum casterFrustum;
+
+			// SNAPPED CENTER IN LIGHT SPACE AND HALF SIZE OF THE PROJECTION
+			Vector3f center;
+			float extent = 0.0f;
+
+			// THE CACHE LAYER MATCHES THE CURRENT PROJECTION
+			bool cacheValid = false;
+			uint64_t cacheHash = 0;
+
+			// THE SHADOW MAP LAYER HOLDS ONLY THE CACHE
+			bool holdsCache = false;
+		};
+
+		void attachLayer(unsigned int framebuffer, unsigned int texture, int layer) const;
+
+		Cascade cascades[SHADOW_CASCADE_COUNT];
+
+		DirectionalLightBuffer lightBuffer = {};
+
+		Vector3f lightDirection;
+
+		// RESTORED BY end()
+		int viewport[4];
+		int previousFramebuffer = 0;
+
+		unsigned int shadowTexture;
+		unsigned int cacheTexture;
+
+		unsigned int framebuffer;
+		unsigned int cacheFramebuffer;
+	};
+}
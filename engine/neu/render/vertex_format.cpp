@@ -0,0 +1,262 @@
+#include "vertex_format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "core.h"
+
+using namespace Neu;
+
+// LARGEST HALF ROUNDING ERROR ALLOWED BY POSITION_PRECISION_AUTO, RELATIVE
+// TO THE LARGEST DIMENSION OF THE MESH
+#define HALF_POSITION_TOLERANCE 1e-3f
+
+VertexLayout VertexLayout::get(uint32_t format)
+{
+	VertexLayout layout;
+
+	if (format & VERTEX_HALF_POSITION)
+	{
+		// THE NORMAL FILLS THE PADDING AFTER THE POSITION
+		layout.stride = 4 * sizeof(uint16_t);
+		layout.normalOffset = 3 * sizeof(uint16_t);
+	}
+	else
+	{
+		layout.stride = 3 * sizeof(float);
+		layout.normalOffset = layout.stride;
+
+		if (format & VERTEX_NORMAL)
+			layout.stride += sizeof(uint32_t);
+	}
+
+	layout.colorOffset = layout.stride;
+	if (format & VERTEX_COLOR)
+		layout.stride += sizeof(uint32_t);
+
+	return layout;
+}
+
+uint32_t Neu::chooseVertexFormat(const std::vector<Vector3f>& positions, bool hasNormals, bool hasColors, PositionPrecision precision)
+{
+	uint32_t format = 0;
+
+	if (hasNormals)
+		format |= VERTEX_NORMAL;
+	if (hasColors)
+		format |= VERTEX_COLOR;
+
+	if (precision == POSITION_PRECISION_HALF)
+		return format | VERTEX_HALF_POSITION;
+
+	if (precision == POSITION_PRECISION_FULL || positions.empty())
+		return format;
+
+	// AUTO: HALF ONLY IF ITS ROUNDING ERROR IS SMALL FOR THE MESH SIZE
+	float largestCoordinate = 0.0f;
+	Vector3f minimum = positions[0];
+	Vector3f maximum = positions[0];
+
+	for (const Vector3f& position : positions)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			largestCoordinate = std::max(largestCoordinate, std::fabs(position[axis]));
+			minimum[axis] = std::min(minimum[axis], position[axis]);
+			maximum[axis] = std::max(maximum[axis], position[axis]);
+		}
+	}
+
+	float size = std::max({ maximum.x - minimum.x, maximum.y - minimum.y, maximum.z - minimum.z });
+
+	// HALFS HAVE 11 SIGNIFICANT BITS AND TOP OUT AT 65504
+	float roundingError = largestCoordinate / 2048.0f;
+
+	if (largestCoordinate < 65504.0f && roundingError <= HALF_POSITION_TOLERANCE * size)
+		format |= VERTEX_HALF_POSITION;
+
+	return format;
+}
+
+void Neu::packVertices(uint32_t format, const std::vector<Vector3f>& positions, const std::vector<Vector3f>& normals, const std::vector<Vector3f>& colors, uint8_t* output)
+{
+	const VertexLayout layout = VertexLayout::get(format);
+
+	for (size_t i = 0; i < positions.size(); i++)
+	{
+		uint8_t* vertex = output + i * layout.stride;
+
+		if (format & VERTEX_HALF_POSITION)
+		{
+			uint16_t half[4] = { packHalf(positions[i].x), packHalf(positions[i].y), packHalf(positions[i].z), 0 };
+
+			if (format & VERTEX_NORMAL)
+				half[3] = packNormal8(normals[i]);
+
+			memcpy(vertex, half, sizeof(half));
+		}
+		else
+		{
+			memcpy(vertex, &positions[i], sizeof(Vector3f));
+
+			if (format & VERTEX_NORMAL)
+			{
+				uint32_t normal = packNormal16(normals[i]);
+				memcpy(vertex + layout.normalOffset, &normal, sizeof(normal));
+			}
+		}
+
+		if (format & VERTEX_COLOR)
+		{
+			uint32_t color = packUnorm8(colors[i]);
+			memcpy(vertex + layout.colorOffset, &color, sizeof(color));
+		}
+	}
+}
+
+void Neu::setVertexAttributePointers(uint32_t format)
+{
+	const VertexLayout layout = VertexLayout::get(format);
+
+	// SAME LOCATIONS AS THE SHADERS: POSITION 0, NORMAL 1, COLOR 2
+	if (format & VERTEX_HALF_POSITION)
+		glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, layout.stride, (void*)0);
+	else
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, layout.stride, (void*)0);
+
+	glEnableVertexAttribArray(0);
+
+	if (format & VERTEX_NORMAL)
+	{
+		const GLenum normalType = (format & VERTEX_HALF_POSITION) ? GL_BYTE : GL_SHORT;
+
+		glVertexAttribPointer(1, 2, normalType, GL_TRUE, layout.stride, (void*)(size_t)layout.normalOffset);
+		glEnableVertexAttribArray(1);
+	}
+
+	if (format & VERTEX_COLOR)
+	{
+		glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, layout.stride, (void*)(size_t)layout.colorOffset);
+		glEnableVertexAttribArray(2);
+	}
+}
+
+/////////////
+// PACKING //
+/////////////
+
+uint16_t Neu::packHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	const uint32_t sign = (bits >> 16) & 0x8000;
+	const uint32_t floatExponent = (bits >> 23) & 0xFF;
+	uint32_t mantissa = bits & 0x7FFFFF;
+
+	// INFINITY AND NAN
+	if (floatExponent == 0xFF)
+		return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+
+	const int exponent = (int)floatExponent - 127 + 15;
+
+	// TOO LARGE, ROUND TO INFINITY
+	if (exponent >= 31)
+		return (uint16_t)(sign | 0x7C00);
+
+	uint32_t half;
+	uint32_t shift;
+
+	if (exponent <= 0)
+	{
+		// TOO SMALL EVEN FOR A SUBNORMAL, ROUND TO ZERO
+		if (exponent < -10)
+			return (uint16_t)sign;
+
+		// SUBNORMAL, MAKE THE IMPLICIT LEADING ONE EXPLICIT
+		mantissa |= 0x800000;
+		shift = 14 - exponent;
+		half = mantissa >> shift;
+	}
+	else
+	{
+		shift = 13;
+		half = ((uint32_t)exponent << 10) | (mantissa >> shift);
+	}
+
+	// ROUND TO NEAREST EVEN, A CARRY INTO THE EXPONENT IS STILL CORRECT
+	const uint32_t remainder = mantissa & ((1u << shift) - 1);
+	const uint32_t halfway = 1u << (shift - 1);
+
+	if (remainder > halfway || (remainder == halfway && (half & 1)))
+		half++;
+
+	return (uint16_t)(sign | half);
+}
+
+/**
+ * Projects the normal onto the octahedron |x| + |y| + |z| = 1 and unfolds
+ * the lower half over the diagonals, giving two coordinates in [-1, 1].
+ */
+static void encodeOctahedral(const Vector3f& normal, float& u, float& v)
+{
+	const float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+
+	// DEGENERATE NORMALS DECODE TO +Z
+	if (length <= 0.0f)
+	{
+		u = 0.0f;
+		v = 0.0f;
+		return;
+	}
+
+	u = normal.x / length;
+	v = normal.y / length;
+
+	if (normal.z < 0.0f)
+	{
+		const float foldedU = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+		const float foldedV = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+
+		u = foldedU;
+		v = foldedV;
+	}
+}
+
+uint16_t Neu::packNormal8(const Vector3f& normal)
+{
+	float u, v;
+	encodeOctahedral(normal, u, v);
+
+	auto packComponent = [](float value)
+	{
+		return (uint16_t)((int)std::lround(std::clamp(value, -1.0f, 1.0f) * 127.0f) & 0xFF);
+	};
+
+	return (uint16_t)(packComponent(u) | (packComponent(v) << 8));
+}
+
+uint32_t Neu::packNormal16(const Vector3f& normal)
+{
+	float u, v;
+	encodeOctahedral(normal, u, v);
+
+	auto packComponent = [](float value)
+	{
+		return (uint32_t)std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f) & 0xFFFF;
+	};
+
+	return packComponent(u) | (packComponent(v) << 16);
+}
+
+uint32_t Neu::packUnorm8(const Vector3f& color)
+{
+	auto packComponent = [](float value)
+	{
+		return (uint32_t)std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f);
+	};
+
+	// ALPHA IS ALWAYS OPAQUE
+	return packComponent(color.x) | (packComponent(color.y) << 8) | (packComponent(color.z) << 16) | (255u << 24);
+}
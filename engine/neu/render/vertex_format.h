@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "math/Vector.h"
+
+namespace Neu
+{
+	// OPTIONAL PER-VERTEX ATTRIBUTES AND ENCODINGS, POSITIONS ARE ALWAYS PRESENT
+	enum VertexAttributes : uint32_t
+	{
+		VERTEX_NORMAL = 1 << 0,
+		VERTEX_COLOR = 1 << 1,
+		VERTEX_HALF_POSITION = 1 << 2,
+		VERTEX_FORMAT_COUNT = 1 << 3  // KEEP AS LAST ITEM
+	};
+
+	// HOW POSITIONS ARE STORED, CHOSEN PER MESH WHEN IT IS CREATED
+	enum PositionPrecision
+	{
+		POSITION_PRECISION_AUTO,  // HALF IF THE ROUNDING ERROR IS SMALL FOR THE MESH SIZE
+		POSITION_PRECISION_FULL,
+		POSITION_PRECISION_HALF
+	};
+
+	/**
+	 * Byte layout of one interleaved vertex:
+	 *   position  float3 (12 bytes), or half3 (6 bytes)
+	 *   normal    octahedral snorm16x2 (4 bytes) after float positions, or
+	 *             octahedral snorm8x2 (2 bytes) in the two bytes after half
+	 *             positions that the 4-byte alignment would otherwise waste
+	 *   color     unorm8 RGBA (4 bytes)
+	 *
+	 * So a full vertex takes 12 bytes with half positions and 20 with float
+	 * positions, against 36 for three float3 streams.
+	 *
+	 * The vertex fetch expands every attribute to floats. Normals arrive as
+	 * the two octahedral coordinates and are decoded (and normalized, they
+	 * are not unit length after quantization) by the vertex shaders.
+	 */
+	struct VertexLayout
+	{
+		uint32_t stride;
+		uint32_t normalOffset;
+		uint32_t colorOffset;
+
+		static VertexLayout get(uint32_t format);
+	};
+
+	/**
+	 * Returns the format for the given attributes, picking half positions if
+	 * allowed by precision.
+	 */
+	uint32_t chooseVertexFormat(const std::vector<Vector3f>& positions, bool hasNormals, bool hasColors, PositionPrecision precision);
+
+	/**
+	 * Writes the interleaved, packed vertices into output (positions.size()
+	 * times the stride of the format).
+	 */
+	void packVertices(uint32_t format, const std::vector<Vector3f>& positions, const std::vector<Vector3f>& normals, const std::vector<Vector3f>& colors, uint8_t* output);
+
+	/**
+	 * Sets the attribute pointers (locations 0 to 2) of the bound VAO for
+	 * vertices of the format in the bound GL_ARRAY_BUFFER.
+	 */
+	void setVertexAttributePointers(uint32_t format);
+
+	uint16_t packHalf(float value);
+
+	// OCTAHEDRAL NORMALS, TWO SNORM8 OR TWO SNORM16 (X IN THE LOW BITS)
+	uint16_t packNormal8(const Vector3f& normal);
+	uint32_t packNormal16(const Vector3f& normal);
+
+	uint32_t packUnorm8(const Vector3f& color);
+}
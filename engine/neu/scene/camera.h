@@ -142,6 +142,9 @@ class Camera {
 
   Vector3f getPosition() const { return position; }
 
+  float getNearPlane() const { return z_near; }
+  float getFarPlane() const { return z_far; }
+
   Vector3f getDirection() const { return direction; }
   Vector3f getRight() const { return right; }
   Vector3f getUp() const { return up; }
@@ -2,52 +2,50 @@
 
 #include <iostream>
 #include <string>
-#include <unordered_map>
+#include <utility>
 
+#include "components/component_manager.h"
 #include "math/Matrix.h"
 #include "math/Vector.h"
 
-static unsigned int uid = 0;
-
 namespace Neu {
 
+/**
+ * Thin handle around an entity. Components are not owned by the game object;
+ * they live in the packed per-type pools of the scene's ComponentManager.
+ */
 class GameObject {
  public:
-  GameObject() : id(uid++) {}
-  ~GameObject() {
-    // TODO: FREE ALL COMPONENTS
-  }
+  GameObject(ComponentManager* componentManager)
+      : componentManager(componentManager),
+        id(componentManager->createEntity()) {}
+  ~GameObject() { componentManager->destroyEntity(id); }
 
   std::string getName() const { return name; }
   void setName(std::string name) { this->name = name; }
 
-  unsigned int getID() const { return id; }
+  Entity getID() const { return id; }
 
-  template <typename T>
-  T& addComponent() {
-    T* c = new T();
-    components.insert({(std::string) typeid(T).name(), (void*)c});
-    return *c;
+  template <typename T, typename... Args>
+  T& addComponent(Args&&... args) {
+    return componentManager->addComponent<T>(id, std::forward<Args>(args)...);
   }
 
   template <typename T>
   T& getComponent() {
-    return *(T*)components[(std::string) typeid(T).name()];
+    return *componentManager->getComponent<T>(id);
   }
 
   template <typename T>
   bool hasComponent() {
-    return components.contains(typeid(T).name());
+    return componentManager->hasComponent<T>(id);
   }
 
-  // DEBUG
-  Vector3f color;
-
  protected:
-  unsigned int id;
-  std::string name;
+  ComponentManager* componentManager;
 
-  std::unordered_map<std::string, void*> components;
+  Entity id;
+  std::string name;
 };
 
 }  // namespace Neu
\ No newline at end of file
@@ -2,23 +2,29 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <fstream>
 #include <json/json.hpp>
+#include <memory>
 #include <random>
 
 #include "application.h"
+#include "components/light.h"
 #include "components/mesh.h"
 #include "components/rigid_body.h"
 #include "components/transform.h"
 #include "game_object.h"
-#include "shader_manager.h"
+#include "render/mesh_arena.h"
 #include "utility/profiler.h"
+#include "utility/thread_pool.h"
 #include "window_manager.h"
 
 using json = nlohmann::json;
 using namespace Neu;
 
-Scene::Scene() {
+Scene::Scene()
+    : systemScheduler(Application::getInstance()->getThreadPool()),
+      fixedSystemScheduler(Application::getInstance()->getThreadPool()) {
   backgroundColor = Vector3f(0.1f, 0.1f, 0.1f);
 
   ////////////////////
@@ -27,6 +33,36 @@ Scene::Scene() {
 
   physicsSystem.setup();
 
+  // SYSTEMS THAT WRITE THE SAME COMPONENTS RUN IN REGISTRATION ORDER
+  ThreadPool* threadPool = Application::getInstance()->getThreadPool();
+
+  fixedSystemScheduler.addSystem(
+      "PhysicsSystem", SystemAccess().write<RigidBodyComponent>(),
+      [this](float deltaTime) {
+        physicsSystem.update(componentManager, deltaTime);
+      });
+
+  // INTERPOLATION WRITES THE TRANSFORMS, SO IT RUNS BEFORE THE MATRICES ARE
+  // BUILT
+  systemScheduler.addSystem(
+      "PhysicsInterpolation",
+      SystemAccess().read<RigidBodyComponent>().write<TransformComponent>(),
+      [this](float) {
+        physicsSystem.interpolate(componentManager, interpolationAlpha);
+      });
+
+  // CHANGES THE MESH BOUNDS, SO IT RUNS BEFORE THE SPATIAL TREE IS UPDATED
+  systemScheduler.addSystem(
+      "WaveMesh", SystemAccess().write<MeshComponent>(),
+      [this](float deltaTime) { updateWaveMesh(deltaTime); });
+
+  systemScheduler.addSystem(
+      "TransformSystem",
+      SystemAccess().write<TransformComponent>().read<MeshComponent>(),
+      [this, threadPool](float) {
+        transformSystem.update(componentManager, *threadPool);
+      });
+
   ////////////////////
   // DEBUG ENTITIES //
   ////////////////////
@@ -65,19 +101,22 @@ Scene::Scene() {
       Vector3i(8, 4, 9),  Vector3i(2, 1, 4),  Vector3i(11, 2, 8),
   };
 
+  // ALL CUBES SHARE ONE MESH SO THEY CAN BE DRAWN IN A SINGLE INSTANCED CALL
+  std::shared_ptr<Mesh> cubeMesh =
+      Application::getInstance()->getMeshArena()->createMesh(vertices, normals,
+                                                              {}, faces);
+
   std::random_device rd;
   std::mt19937 gen(rd());
   std::uniform_real_distribution<float> uniformPositiveDistribution(0.0f, 1.0f);
 
   for (int i = 0; i < 100; i++) {
-    GameObject* cube = new GameObject();
+    GameObject* cube = new GameObject(&componentManager);
 
     Vector4f randomParticleColor = Vector4f(
         uniformPositiveDistribution(gen), uniformPositiveDistribution(gen),
         uniformPositiveDistribution(gen), uniformPositiveDistribution(gen));
 
-    cube->color = randomParticleColor;
-
     // cube->setColor(Vector3f(0.5294f, 0.8078f, 0.9216f));
     auto& transform = cube->addComponent<TransformComponent>();
     transform.position = Vector3f(0.0f, 4.0f * i, 0.0f);
@@ -89,21 +128,108 @@ Scene::Scene() {
     cube->addComponent<RigidBodyComponent>();
 
     auto& mesh = cube->addComponent<MeshComponent>();
-    mesh.setupVertices(vertices);
-    mesh.setupNormals(normals);
-    mesh.setupFaces(faces);
+    mesh.mesh = cubeMesh;
+    mesh.color = randomParticleColor;
 
     gameObjects.push_back(cube);
     physicsSystem.addBody(cube);
   }
 
+  //////////////////
+  // DEBUG LIGHTS //
+  //////////////////
+
+  std::uniform_real_distribution<float> lightDistribution(-30.0f, 30.0f);
+
+  for (int i = 0; i < 256; i++) {
+    GameObject* lightObject = new GameObject(&componentManager);
+
+    auto& transform = lightObject->addComponent<TransformComponent>();
+    transform.position =
+        Vector3f(lightDistribution(gen),
+                 1.0f + 9.0f * uniformPositiveDistribution(gen),
+                 lightDistribution(gen));
+
+    auto& light = lightObject->addComponent<LightComponent>();
+    light.color = Vector3f(uniformPositiveDistribution(gen),
+                           uniformPositiveDistribution(gen),
+                           uniformPositiveDistribution(gen));
+    light.radius = 4.0f + 6.0f * uniformPositiveDistribution(gen);
+
+    gameObjects.push_back(lightObject);
+  }
+
+  ////////////////////
+  // DEBUG SUNLIGHT //
+  ////////////////////
+
+  // SAME AS THE LIGHT OF test.json (FROM [4, 4, 4] TOWARDS THE ORIGIN)
+  GameObject* sun = new GameObject(&componentManager);
+
+  auto& sunLight = sun->addComponent<DirectionalLightComponent>();
+  sunLight.direction = normalize(Vector3f(-4.0f, -4.0f, -4.0f));
+  sunLight.color = Vector3f(1.0f, 0.95f, 0.85f);
+  sunLight.intensity = 0.8f;
+  sunLight.castsShadows = true;
+
+  gameObjects.push_back(sun);
+
+  // STATIC SHADOW RECEIVER OVER THE PHYSICS FLOOR (NO RIGID BODY, SO ITS
+  // SHADOWS ARE CACHED)
+  GameObject* ground = new GameObject(&componentManager);
+
+  auto& groundTransform = ground->addComponent<TransformComponent>();
+  groundTransform.position = Vector3f(0.0f, -1.0f, 0.0f);
+  groundTransform.scale = Vector3f(100.0f, 1.0f, 100.0f);
+
+  auto& groundMesh = ground->addComponent<MeshComponent>();
+  groundMesh.mesh = cubeMesh;
+  groundMesh.color = Vector3f(0.6f, 0.6f, 0.6f);
+
+  gameObjects.push_back(ground);
+
+  /////////////////////
+  // DEBUG WAVE MESH //
+  /////////////////////
+
+  const int waveQuads = WAVE_RESOLUTION - 1;
+
+  for (int z = 0; z < waveQuads; z++) {
+    for (int x = 0; x < waveQuads; x++) {
+      const int corner = z * WAVE_RESOLUTION + x;
+
+      waveFaces.push_back(
+          Vector3i(corner, corner + WAVE_RESOLUTION, corner + 1));
+      waveFaces.push_back(Vector3i(corner + 1, corner + WAVE_RESOLUTION,
+                                   corner + WAVE_RESOLUTION + 1));
+    }
+  }
+
+  wavePositions.resize(WAVE_RESOLUTION * WAVE_RESOLUTION);
+  waveNormals.resize(WAVE_RESOLUTION * WAVE_RESOLUTION);
+
+  // EMPTY (AND LEFT OUT OF THE SPATIAL TREE) UNTIL THE FIRST UPDATE
+  waveMesh = Application::getInstance()->getMeshArena()->createDynamicMesh(
+      VERTEX_NORMAL, static_cast<uint32_t>(wavePositions.size()),
+      static_cast<uint32_t>(waveFaces.size() * 3));
+
+  GameObject* wave = new GameObject(&componentManager);
+
+  auto& waveTransform = wave->addComponent<TransformComponent>();
+  waveTransform.position = Vector3f(-6.0f, 0.5f, 0.0f);
+  waveTransform.scale = Vector3f(3.0f, 3.0f, 3.0f);
+
+  auto& waveMeshComponent = wave->addComponent<MeshComponent>();
+  waveMeshComponent.mesh = waveMesh;
+  waveMeshComponent.color = Vector3f(0.2f, 0.5f, 0.9f);
+
+  gameObjects.push_back(wave);
+
   //////////////////////////////
   // ADD CHARACTER CONTROLLER //
   //////////////////////////////
 
-  GameObject* player = new GameObject();
-
-  player->color = Vector3f(1.0f, 0.0f, 0.0f);
+  GameObject* player = new GameObject(&componentManager);
 
   auto& transform = player->addComponent<TransformComponent>();
   transform.position = Vector3f(0.0f, 4.0f, 0.0f);
@@ -113,9 +239,8 @@ Scene::Scene() {
   player->addComponent<RigidBodyComponent>();
 
   auto& mesh = player->addComponent<MeshComponent>();
-  mesh.setupVertices(vertices);
-  mesh.setupNormals(normals);
-  mesh.setupFaces(faces);
+  mesh.mesh = cubeMesh;
+  mesh.color = Vector3f(1.0f, 0.0f, 0.0f);
 
   gameObjects.push_back(player);
   physicsSystem.addController(player);
@@ -146,25 +271,32 @@ void Scene::update(float deltaTime) {
   // UPDATE CAMERA //
   ///////////////////
 
+  // THE RENDERER UPLOADS THE MATRICES FROM ITS SNAPSHOT
   camera.update(deltaTime);
 
-  Application::getInstance()->getShaderManager()->updateUniformBuffer(
-      "camera", 0, sizeof(Matrix4x4f), camera.getViewMatrix().ptr());
-  Application::getInstance()->getShaderManager()->updateUniformBuffer(
-      "camera", sizeof(Matrix4x4f), sizeof(Matrix4x4f),
-      camera.getProjectionMatrix());
-
   ////////////////////
   // UPDATE SYSTEMS //
   ////////////////////
 
-  // for (auto* gameObject : gameObjects)
-  //{
-  transformSystem.update(gameObjects);
   // controllerSystem.update(gameObjects); // TODO: CONTROLLER SYSTEM IS NOT
   // FUNCTIONAL
-  physicsSystem.update(gameObjects, deltaTime);
-  //}
+
+  accumulator += deltaTime;
+
+  for (fixedSteps = 0;
+       accumulator >= FIXED_TIME_STEP && fixedSteps < MAX_FIXED_STEPS;
+       fixedSteps++) {
+    fixedSystemScheduler.run(FIXED_TIME_STEP);
+    accumulator -= FIXED_TIME_STEP;
+  }
+
+  // OUT OF STEPS, KEEP ONLY THE FRACTION OF A STEP
+  if (accumulator >= FIXED_TIME_STEP)
+    accumulator = std::fmod(accumulator, FIXED_TIME_STEP);
+
+  interpolationAlpha = accumulator / FIXED_TIME_STEP;
+
+  systemScheduler.run(deltaTime);
 
   ///////////////////
   // UPDATE LIGHTS //
@@ -174,4 +306,64 @@ void Scene::update(float deltaTime) {
   //	light->update(deltaTime);
 
   // PROFILE_STOP;
-}
\ No newline at end of file
+}
+
+void Scene::updateWaveMesh(float deltaTime) {
+  waveTime += deltaTime;
+
+  const float scale = 2.0f / (WAVE_RESOLUTION - 1);
+
+  for (int z = 0; z < WAVE_RESOLUTION; z++) {
+    for (int x = 0; x < WAVE_RESOLUTION; x++) {
+      // [-1, 1] ON BOTH AXES
+      const float u = x * scale - 1.0f;
+      const float v = z * scale - 1.0f;
+      const float radius = std::sqrt(u * u + v * v);
+
+      const float phase = 8.0f * radius - 4.0f * waveTime;
+      const float height = 0.1f * std::sin(phase);
+
+      // DERIVATIVE OF THE HEIGHT ALONG THE RADIUS, SPLIT ONTO BOTH AXES
+      const float slope =
+          radius > 0.0f ? 0.8f * std::cos(phase) / radius : 0.0f;
+
+      const int index = z * WAVE_RESOLUTION + x;
+
+      wavePositions[index] = Vector3f(u, height, v);
+      waveNormals[index] = normalize(Vector3f(-slope * u, 1.0f, -slope * v));
+    }
+  }
+
+  waveMesh->update(wavePositions, waveNormals, {}, waveFaces);
+}
+
+Entity Scene::raycast(const Vector3f& origin, const Vector3f& direction,
+                      float maxDistance, float* hitDistance) {
+  const Vector3f inverseDirection(1.0f / direction.x, 1.0f / direction.y,
+                                  1.0f / direction.z);
+
+  Entity closest = NULL_ENTITY;
+
+  transformSystem.getSpatialTree().raycast(
+      origin, direction, maxDistance, [&](Entity entity, float maxDistance) {
+        TransformComponent* transform =
+            componentManager.getComponent<TransformComponent>(entity);
+        MeshComponent* mesh = componentManager.getComponent<MeshComponent>(entity);
+        if (!transform || !mesh || !mesh->mesh) return maxDistance;
+
+        // CLIP THE RAY AT EVERY HIT SO ONLY CLOSER LEAVES ARE VISITED
+        float distance;
+        if (!mesh->mesh->getBounds()
+                 .transformed(transform->transform)
+                 .intersectsRay(origin, inverseDirection, maxDistance,
+                                distance))
+          return maxDistance;
+
+        closest = entity;
+        if (hitDistance) *hitDistance = distance;
+
+        return distance;
+      });
+
+  return closest;
+}
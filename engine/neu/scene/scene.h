@@ -1,30 +1,56 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
+#include "components/component_manager.h"
 #include "fps_camera.h"
 #include "systems/physics_system.h"
+#include "systems/system_scheduler.h"
 #include "systems/transform.h"
 
 namespace Neu {
 
 class GameObject;
 class Application;
+class Mesh;
 
 class Scene {
  public:
   Scene();
 
+  /**
+   * Runs the simulation systems in fixed steps of FIXED_TIME_STEP for the
+   * time accumulated so far, then the per-frame systems, which interpolate
+   * the simulated transforms between the last two steps.
+   */
   void update(float deltaTime);
 
   inline std::vector<GameObject*> getGameObjects() const { return gameObjects; }
   // inline std::vector<Light*> getLights() const { return lights; }
   inline Vector3f getBackgroundColor() const { return backgroundColor; }
   inline FPSCamera& getCamera() { return camera; }
+  inline ComponentManager& getComponentManager() { return componentManager; }
+  inline PhysicsSystem& getPhysicsSystem() { return physicsSystem; }
+  inline TransformSystem& getTransformSystem() { return transformSystem; }
+
+  // FRACTION OF A FIXED STEP THE RENDERED FRAME IS AHEAD OF THE PREVIOUS STEP
+  inline float getInterpolationAlpha() const { return interpolationAlpha; }
+  inline int getFixedSteps() const { return fixedSteps; }
+
+  /**
+   * Returns the closest entity whose world mesh bounds are hit by the ray
+   * (e.g. for mouse picking), or NULL_ENTITY. The direction does not need to
+   * be normalized; distances are measured in multiples of it.
+   */
+  Entity raycast(const Vector3f& origin, const Vector3f& direction,
+                 float maxDistance, float* hitDistance = nullptr);
 
  private:
   Application* application;
 
+  ComponentManager componentManager;
+
   /////////////
   // SYSTEMS //
   /////////////
@@ -32,6 +58,43 @@ class Scene {
   Neu::PhysicsSystem physicsSystem;
   TransformSystem transformSystem;
 
+  // RUN ONCE PER FRAME
+  SystemScheduler systemScheduler;
+
+  // RUN ONCE PER FIXED STEP
+  SystemScheduler fixedSystemScheduler;
+
+  ////////////////
+  // FIXED STEP //
+  ////////////////
+
+  static constexpr float FIXED_TIME_STEP = 1.0f / 60.0f;
+
+  // FRAMES THAT TAKE LONGER DROP THE REST OF THEIR TIME INSTEAD OF FALLING
+  // FURTHER BEHIND (THE SIMULATION SLOWS DOWN)
+  static constexpr int MAX_FIXED_STEPS = 4;
+
+  float accumulator = 0.0f;
+  float interpolationAlpha = 0.0f;
+  int fixedSteps = 0;  // IN THE LAST UPDATE
+
+  /////////////////////
+  // DEBUG WAVE MESH //
+  /////////////////////
+
+  // VERTICES PER SIDE OF THE GRID
+  static constexpr int WAVE_RESOLUTION = 32;
+
+  // A DYNAMIC MESH, REWRITTEN EVERY FRAME
+  std::shared_ptr<Mesh> waveMesh;
+  std::vector<Vector3f> wavePositions;
+  std::vector<Vector3f> waveNormals;
+  std::vector<Vector3i> waveFaces;
+  float waveTime = 0.0f;
+
+  // STREAMS THE NEXT FRAME OF THE RIPPLE INTO waveMesh
+  void updateWaveMesh(float deltaTime);
+
   FPSCamera camera;
   std::vector<GameObject*> gameObjects;
   // std::vector<Light*> lights;
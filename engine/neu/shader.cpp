@@ -1,156 +1,505 @@
 #include "shader.h"
 
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
 #include <fstream>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "core.h"
 #include "math/Matrix.h"
 #include "math/Vector.h"
+#include "render/gl_extensions.h"
 
 using std::ifstream;
 using std::string;
-using std::stringstream;
 
 using namespace Neu;
 
 /**
- * Empty constructor.
+ * 64-bit FNV-1a, chained through hash so several strings can be combined.
  */
-Shader::Shader() {}
+static uint64_t hashBytes(const void *data, size_t size,
+                          uint64_t hash = 14695981039346656037ull) {
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
 
-Shader::Shader(const string &vertexShaderPath,
-               const string &fragmentShaderPath) {
-  ID = glCreateProgram();
-  Shader::attachShader(vertexShaderPath, GL_VERTEX_SHADER);
-  Shader::attachShader(fragmentShaderPath, GL_FRAGMENT_SHADER);
-  link();
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
 
-  // DEBUG
+  return hash;
+}
 
-  GLint numBlocks;
-  GLint nameLen;
+static bool readFile(const string &path, string &contents) {
+  ifstream file(path, std::ios::binary | std::ios::ate);
 
-  std::vector<string> nameList;
+  if (!file) {
+    Logger::error("Failed to read shader file \"%s\"\n", path.c_str());
+    return false;
+  }
+
+  contents.resize(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  file.read(contents.data(), contents.size());
 
-  glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCKS, &numBlocks);
-  nameList.reserve(numBlocks);
+  return static_cast<bool>(file);
+}
 
-  Logger::debug("Found %d %s in shader \"%s\"\n", numBlocks,
-                numBlocks == 1 ? "block" : "blocks", name.c_str());
+/**
+ * Inserts defines after the #version directive, which has to come first.
+ */
+static void injectDefines(string &source, const string &defines) {
+  size_t position = 0;
+  int versionLines = 0;
+
+  if (source.compare(0, 8, "#version") == 0) {
+    position = source.find('\n');
+    position = position == string::npos ? source.size() : position + 1;
+    versionLines = 1;
+  }
 
-  for (int blockIx = 0; blockIx < numBlocks; blockIx++) {
-    glGetActiveUniformBlockiv(ID, blockIx, GL_UNIFORM_BLOCK_NAME_LENGTH,
-                              &nameLen);
+  // KEEPS THE LINE NUMBERS OF COMPILER ERRORS MATCHING THE FILE
+  source.insert(position,
+                defines + "#line " + std::to_string(versionLines + 1) + "\n");
+}
 
-    std::vector<GLchar> name;
-    name.resize(nameLen);
-    glGetActiveUniformBlockName(ID, blockIx, nameLen, NULL, &name[0]);
+const string &Shader::getDriverString() {
+  static const string driver = [] {
+    string result;
 
-    nameList.push_back(std::string());
-    nameList.back().assign(name.begin(),
-                           name.end() - 1);  // Remove the null terminator.
-  }
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+      const GLubyte *value = glGetString(name);
+      if (value) result += reinterpret_cast<const char *>(value);
+      result += '\n';
+    }
 
-  for (unsigned int il = 0; il < nameList.size(); il++) {
-    Logger::debug("Block name: %s\n", nameList[il].c_str());
-  }
+    return result;
+  }();
 
-  Logger::info(
-      "Created shader program (%d) with vertex shader \"%s\" and fragment "
-      "shader \"%s\"\n",
-      ID, vertexShaderPath.c_str(), fragmentShaderPath.c_str());
+  return driver;
 }
 
-void Shader::attachShader(const string &shaderPath,
-                          unsigned int shaderType) const {
-  string shaderCode;
-  ifstream shaderFile;
+/**
+ * Empty constructor.
+ */
+Shader::Shader() {}
 
-  shaderFile.exceptions(ifstream::failbit | ifstream::badbit);
+Shader::Shader(const Sources &sources) {
+  ID = glCreateProgram();
 
-  try {
-    shaderFile.open(shaderPath);
-    stringstream shaderStream;
+  Logger::info(
+      "Building shader program (%d) with vertex shader \"%s\" and fragment "
+      "shader \"%s\"\n",
+      ID, sources.vertexShaderPath.c_str(), sources.fragmentShaderPath.c_str());
 
-    shaderStream << shaderFile.rdbuf();
+  linkPending = true;
 
-    shaderFile.close();
+  cachePath = sources.cachePath;
+  cacheKey = sources.cacheKey;
 
-    shaderCode = shaderStream.str();
-  } catch (ifstream::failure e) {
-    Logger::error("Failed to read shader file \"%s\"\n", shaderPath.c_str());
+  if (!sources.binary.empty() && loadBinary(sources)) {
+    loadedFromCache = true;
     return;
   }
 
-  const char *vShaderCode = shaderCode.c_str();
-  unsigned int shaderID;
-  int success;
-  char infoLog[512];
-
-  shaderID = glCreateShader(shaderType);
-  glShaderSource(shaderID, 1, &vShaderCode, NULL);
-  glCompileShader(shaderID);
+  // THE BINARY CAN ONLY BE RETRIEVED IF THIS IS SET BEFORE LINKING
+  if (!cachePath.empty())
+    GLExtensions::programParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                                    GL_TRUE);
 
-  glGetShaderiv(shaderID, GL_COMPILE_STATUS, &success);
-  if (!success) {
-    glGetShaderInfoLog(shaderID, 512, NULL, infoLog);
-    Logger::error("Shader compilation failed \"%s\"\n", infoLog);
-    return;
+  if (sources.valid) {
+    vertexShaderID = compileShader(sources.vertexSource, GL_VERTEX_SHADER);
+    fragmentShaderID =
+        compileShader(sources.fragmentSource, GL_FRAGMENT_SHADER);
   }
 
-  glAttachShader(ID, shaderID);
+  // ERRORS ARE CHECKED IN finishLinking SO THE DRIVER CAN WORK IN THE
+  // BACKGROUND
+  glLinkProgram(ID);
+}
+
+Shader::Sources Shader::readSources(const string &vertexShaderPath,
+                                    const string &fragmentShaderPath) {
+  Sources sources;
+  sources.vertexShaderPath = vertexShaderPath;
+  sources.fragmentShaderPath = fragmentShaderPath;
+
+  const bool vertexRead = readFile(vertexShaderPath, sources.vertexSource);
+  const bool fragmentRead =
+      readFile(fragmentShaderPath, sources.fragmentSource);
+
+  sources.valid = vertexRead && fragmentRead;
+
+  return sources;
+}
+
+bool Shader::isReady() const {
+  if (!linkPending || !GLExtensions::hasParallelShaderCompile) return true;
+
+  GLint completed = GL_FALSE;
+  glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &completed);
 
-  glDeleteShader(shaderID);
+  return completed == GL_TRUE;
 }
 
-void Shader::link() const {
+void Shader::finishLinking() {
+  if (!linkPending) return;
+
+  linkPending = false;
+
   int success;
   char infoLog[512];
 
-  glLinkProgram(ID);
   glGetProgramiv(ID, GL_LINK_STATUS, &success);
 
   if (!success) {
+    for (unsigned int shaderID : {vertexShaderID, fragmentShaderID}) {
+      if (!shaderID) continue;
+
+      glGetShaderiv(shaderID, GL_COMPILE_STATUS, &success);
+
+      if (!success) {
+        glGetShaderInfoLog(shaderID, 512, NULL, infoLog);
+        Logger::error("Shader compilation failed \"%s\"\n", infoLog);
+      }
+    }
+
     glGetProgramInfoLog(ID, 512, NULL, infoLog);
     Logger::error("Shader program linking failed\n%s", infoLog);
     exit(1);
   }
+
+  for (unsigned int *shaderID : {&vertexShaderID, &fragmentShaderID}) {
+    if (!*shaderID) continue;
+
+    glDetachShader(ID, *shaderID);
+    glDeleteShader(*shaderID);
+    *shaderID = 0;
+  }
+
+  reflect();
+
+  if (!loadedFromCache && !cachePath.empty()) saveBinary();
+}
+
+unsigned int Shader::compileShader(const string &source,
+                                   unsigned int shaderType) const {
+  const char *code = source.c_str();
+
+  unsigned int shaderID = glCreateShader(shaderType);
+  glShaderSource(shaderID, 1, &code, NULL);
+  glCompileShader(shaderID);
+
+  glAttachShader(ID, shaderID);
+
+  return shaderID;
+}
+
+//////////////////
+// BINARY CACHE //
+//////////////////
+
+#define PROGRAM_BINARY_MAGIC 0x5550454Eu  // "NEUP"
+
+struct ProgramBinaryHeader {
+  uint32_t magic;
+  uint32_t binaryFormat;
+  uint64_t key;
+  uint32_t length;
+};
+
+void Shader::prepareSources(Sources &sources, const string &defines,
+                            const string &cacheDirectory) {
+  if (!sources.valid) return;
+
+  if (!defines.empty()) {
+    injectDefines(sources.vertexSource, defines);
+    injectDefines(sources.fragmentSource, defines);
+  }
+
+  if (!GLExtensions::hasProgramBinary || cacheDirectory.empty()) return;
+
+  // THE DRIVER STRING IS PART OF THE KEY SO DRIVER UPDATES INVALIDATE IT
+  // THE NULL TERMINATORS SEPARATE THE SOURCES
+  uint64_t key =
+      hashBytes(sources.vertexSource.c_str(), sources.vertexSource.size() + 1);
+  key = hashBytes(sources.fragmentSource.c_str(),
+                  sources.fragmentSource.size() + 1, key);
+  key = hashBytes(getDriverString().data(), getDriverString().size(), key);
+
+  char fileName[32];
+  snprintf(fileName, sizeof(fileName), "%016llx.bin",
+           static_cast<unsigned long long>(key));
+
+  sources.cacheKey = key;
+  sources.cachePath = cacheDirectory + "/" + fileName;
+
+  ifstream file(sources.cachePath, std::ios::binary);
+  if (!file) return;
+
+  ProgramBinaryHeader header;
+
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      header.magic != PROGRAM_BINARY_MAGIC || header.key != key)
+    return;
+
+  sources.binary.resize(header.length);
+
+  if (!file.read(sources.binary.data(), sources.binary.size())) {
+    sources.binary.clear();
+    return;
+  }
+
+  sources.binaryFormat = header.binaryFormat;
+}
+
+bool Shader::loadBinary(const Sources &sources) {
+  GLExtensions::programBinary(ID, sources.binaryFormat, sources.binary.data(),
+                              static_cast<GLsizei>(sources.binary.size()));
+
+  int success;
+  glGetProgramiv(ID, GL_LINK_STATUS, &success);
+
+  if (!success) {
+    Logger::info("Program binary \"%s\" was rejected, compiling from source\n",
+                 cachePath.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+void Shader::saveBinary() const {
+  GLint length = 0;
+  glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+
+  if (length <= 0) return;
+
+  std::vector<char> binary(length);
+  GLenum binaryFormat = 0;
+
+  GLExtensions::getProgramBinary(ID, length, &length, &binaryFormat,
+                                 binary.data());
+
+  std::error_code error;
+  std::filesystem::create_directories(
+      std::filesystem::path(cachePath).parent_path(), error);
+
+  // WRITTEN UNDER A TEMPORARY NAME SO A CRASH NEVER LEAVES A TRUNCATED BINARY
+  const string temporaryPath = cachePath + ".tmp";
+
+  {
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+
+    ProgramBinaryHeader header = {PROGRAM_BINARY_MAGIC, binaryFormat, cacheKey,
+                                  static_cast<uint32_t>(length)};
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(binary.data(), length);
+
+    if (!file) {
+      Logger::warn("Failed to write program binary \"%s\"\n",
+                   temporaryPath.c_str());
+      return;
+    }
+  }
+
+  std::filesystem::rename(temporaryPath, cachePath, error);
+
+  if (error)
+    Logger::warn("Failed to store program binary \"%s\"\n", cachePath.c_str());
 }
 
 void Shader::use() const { glUseProgram(ID); }
 
-void Shader::bindUniformBlock(const string &blockName,
+bool Shader::bindUniformBlock(HashedName blockName,
                               unsigned int bindingPoint) {
-  unsigned int blockIndex = glGetUniformBlockIndex(ID, blockName.c_str());
+  auto block = std::lower_bound(
+      uniformBlocks.begin(), uniformBlocks.end(), blockName.hash,
+      [](const UniformBlock& block, uint32_t hash) { return block.hash < hash; });
+
+  if (block == uniformBlocks.end() || block->hash != blockName.hash)
+    return false;
 
   Logger::info(
-      "Binding uniform block \"%s\" to binding point %d (block index: %d) in "
+      "Binding uniform block %08x to binding point %d (block index: %d) in "
       "shader \"%s\"\n",
-      blockName.c_str(), bindingPoint, blockIndex, name.c_str());
+      blockName.hash, bindingPoint, block->index, name.c_str());
 
-  glUniformBlockBinding(ID, blockIndex, bindingPoint);
+  glUniformBlockBinding(ID, block->index, bindingPoint);
+  return true;
 }
 
 void Shader::setName(const string name) { this->name = name; }
 
-void Shader::setInteger(const string &name, int value) {
-  glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+UniformHandle Shader::getUniform(HashedName name) const {
+  auto uniform = std::lower_bound(
+      uniforms.begin(), uniforms.end(), name.hash,
+      [](const Uniform& uniform, uint32_t hash) { return uniform.hash < hash; });
+
+  if (uniform == uniforms.end() || uniform->hash != name.hash)
+    return INVALID_UNIFORM;
+
+  return static_cast<UniformHandle>(uniform - uniforms.begin());
+}
+
+void Shader::setInteger(UniformHandle uniform, int value) {
+  if (cacheUniform(uniform, &value, sizeof(value)))
+    glUniform1i(uniforms[uniform].location, value);
+}
+
+void Shader::setVector3f(UniformHandle uniform, const Vector3f &value) {
+  if (cacheUniform(uniform, &value, sizeof(value)))
+    glUniform3f(uniforms[uniform].location, value.x, value.y, value.z);
+}
+
+void Shader::setVector3f(UniformHandle uniform, float x, float y, float z) {
+  setVector3f(uniform, Vector3f(x, y, z));
+}
+
+void Shader::setMatrix4x4f(UniformHandle uniform, const Matrix4x4f &value) {
+  if (cacheUniform(uniform, *value.data, sizeof(value.data)))
+    glUniformMatrix4fv(uniforms[uniform].location, 1, GL_FALSE, *value.data);
 }
 
-void Shader::setVector3f(const string &name, const Vector3f &value) {
-  glUniform3f(glGetUniformLocation(ID, name.c_str()), value.x, value.y,
-              value.z);
+bool Shader::cacheUniform(UniformHandle uniform, const void *value,
+                          uint32_t size) {
+  if (uniform < 0 || uniform >= static_cast<UniformHandle>(uniforms.size()))
+    return false;
+
+  const Uniform &entry = uniforms[uniform];
+
+  if (entry.cacheSize != size) {
+    Logger::error("Uniform %08x in shader \"%s\" has a different type\n",
+                  entry.hash, name.c_str());
+    return false;
+  }
+
+  uint8_t *cached = uniformValues.data() + entry.cacheOffset;
+
+  if (memcmp(cached, value, size) == 0) return false;
+
+  memcpy(cached, value, size);
+  return true;
 }
 
-void Shader::setVector3f(const string &name, float x, float y, float z) {
-  glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+////////////////
+// REFLECTION //
+////////////////
+
+/**
+ * Bytes cached for one element of a uniform of the given type.
+ */
+static uint32_t getUniformTypeSize(GLenum type) {
+  switch (type) {
+    case GL_FLOAT_VEC2:
+    case GL_INT_VEC2:
+      return 2 * sizeof(float);
+    case GL_FLOAT_VEC3:
+    case GL_INT_VEC3:
+      return 3 * sizeof(float);
+    case GL_FLOAT_VEC4:
+    case GL_INT_VEC4:
+      return 4 * sizeof(float);
+    case GL_FLOAT_MAT3:
+      return 9 * sizeof(float);
+    case GL_FLOAT_MAT4:
+      return 16 * sizeof(float);
+    default:
+      // SCALARS, BOOLEANS AND SAMPLERS
+      return sizeof(float);
+  }
 }
 
-void Shader::setMatrix4x4f(const string &name, const Matrix4x4f &value) {
-  glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE,
-                     *value.data);
+void Shader::reflect() {
+  uniforms.clear();
+  uniformBlocks.clear();
+
+  GLint maxNameLength = 0;
+  GLint uniformCount = 0;
+
+  glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+  glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &uniformCount);
+
+  std::vector<GLchar> nameBuffer(std::max(maxNameLength, 1));
+  uint32_t cacheSize = 0;
+
+  for (GLint i = 0; i < uniformCount; i++) {
+    GLsizei nameLength = 0;
+    GLint arraySize = 0;
+    GLenum type = 0;
+
+    glGetActiveUniform(ID, i, static_cast<GLsizei>(nameBuffer.size()),
+                       &nameLength, &arraySize, &type, nameBuffer.data());
+
+    std::string_view uniformName(nameBuffer.data(), nameLength);
+
+    // ARRAYS ARE REPORTED AS "name[0]"
+    if (uniformName.size() > 3 &&
+        uniformName.substr(uniformName.size() - 3) == "[0]")
+      uniformName.remove_suffix(3);
+
+    // MEMBERS OF UNIFORM BLOCKS HAVE NO LOCATION
+    GLint location = glGetUniformLocation(ID, nameBuffer.data());
+    if (location < 0) continue;
+
+    Uniform uniform;
+    uniform.hash = HashedName::fromString(uniformName).hash;
+    uniform.location = location;
+    uniform.type = type;
+    uniform.cacheOffset = cacheSize;
+    uniform.cacheSize = getUniformTypeSize(type);
+
+    cacheSize += uniform.cacheSize;
+    uniforms.push_back(uniform);
+
+    Logger::debug("Found uniform \"%.*s\" (location %d) in shader \"%s\"\n",
+                  static_cast<int>(uniformName.size()), uniformName.data(),
+                  location, name.c_str());
+  }
+
+  // UNIFORMS ARE ZERO AFTER A SUCCESSFUL LINK, SO THE CACHE STARTS IN SYNC
+  uniformValues.assign(cacheSize, 0);
+
+  GLint blockCount = 0;
+  glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+
+  for (GLint i = 0; i < blockCount; i++) {
+    GLint nameLength = 0;
+    glGetActiveUniformBlockiv(ID, i, GL_UNIFORM_BLOCK_NAME_LENGTH, &nameLength);
+
+    std::vector<GLchar> blockName(std::max(nameLength, 1));
+    glGetActiveUniformBlockName(ID, i, nameLength, NULL, blockName.data());
+
+    UniformBlock block;
+    block.hash = HashedName::fromString(blockName.data()).hash;
+    block.index = static_cast<unsigned int>(i);
+    glGetActiveUniformBlockiv(ID, i, GL_UNIFORM_BLOCK_DATA_SIZE,
+                              &block.dataSize);
+
+    uniformBlocks.push_back(block);
+
+    Logger::debug("Found block \"%s\" (%d bytes) in shader \"%s\"\n",
+                  blockName.data(), block.dataSize, name.c_str());
+  }
+
+  auto byHash = [](const auto &a, const auto &b) { return a.hash < b.hash; };
+  std::sort(uniforms.begin(), uniforms.end(), byHash);
+  std::sort(uniformBlocks.begin(), uniformBlocks.end(), byHash);
+
+  for (size_t i = 1; i < uniforms.size(); i++)
+    if (uniforms[i].hash == uniforms[i - 1].hash)
+      Logger::error("Uniform name hash collision in shader \"%s\"\n",
+                    name.c_str());
+
+  for (size_t i = 1; i < uniformBlocks.size(); i++)
+    if (uniformBlocks[i].hash == uniformBlocks[i - 1].hash)
+      Logger::error("Uniform block name hash collision in shader \"%s\"\n",
+                    name.c_str());
 }
 
 void Shader::deleteProgram() {
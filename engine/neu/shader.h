@@ -1,47 +1,193 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include "math/Matrix.h"
 #include "math/Vector.h"
+#include "utility/hashed_name.h"
 
 namespace Neu {
 
+/**
+ * Index into the uniform table of one shader, see Shader::getUniform.
+ */
+typedef int32_t UniformHandle;
+
+#define INVALID_UNIFORM -1
+
 class Shader {
  public:
+  /**
+   * Everything a program is built from: the source text and, if the binary
+   * cache holds a program for it, the binary. Reading them only touches
+   * files, so it can happen on any thread (see ShaderManager).
+   */
+  struct Sources {
+    std::string vertexShaderPath;
+    std::string fragmentShaderPath;
+
+    std::string vertexSource;
+    std::string fragmentSource;
+
+    // BOTH FILES WERE READ
+    bool valid = false;
+
+    // EMPTY IF THE BINARY CACHE IS NOT USED
+    std::string cachePath;
+    uint64_t cacheKey = 0;
+
+    // EMPTY IF THE CACHE HAS NO MATCHING BINARY
+    std::vector<char> binary;
+    uint32_t binaryFormat = 0;
+  };
+
   Shader();
-  Shader(const std::string& vertexShaderPath,
-         const std::string& fragmentShaderPath);
 
-  void link() const;
+  /**
+   * Starts building the program, from the cached binary of sources if it has
+   * one, otherwise from source. The program cannot be used before
+   * finishLinking.
+   */
+  explicit Shader(const Sources& sources);
+
+  /**
+   * Reads the source files of both stages.
+   */
+  static Sources readSources(const std::string& vertexShaderPath,
+                             const std::string& fragmentShaderPath);
+
+  /**
+   * Inserts defines after the #version line of both stages and reads the
+   * cached binary from cacheDirectory if one matches the sources and the
+   * driver. An empty cacheDirectory disables the binary cache. Can run on
+   * any thread once getDriverString has been called on the GL thread.
+   */
+  static void prepareSources(Sources& sources, const std::string& defines,
+                             const std::string& cacheDirectory);
+
+  /**
+   * Identifies the driver, program binaries from other drivers are useless.
+   * The first call must be on the GL thread, later calls return the stored
+   * string.
+   */
+  static const std::string& getDriverString();
+
+  /**
+   * Returns true if finishLinking will not block. With
+   * KHR_parallel_shader_compile the driver compiles in the background, so
+   * this can be polled while doing other work.
+   */
+  bool isReady() const;
+
+  /**
+   * Checks the link status (exits on errors), reflects the uniforms and
+   * stores the binary in the cache.
+   */
+  void finishLinking();
+
+  bool isLinked() const { return !linkPending; }
+  bool isLoadedFromCache() const { return loadedFromCache; }
+
   void use() const;
 
-  void bindUniformBlock(const std::string& blockName,
-                        unsigned int bindingPoint);
+  /**
+   * Returns false if the program has no active block of that name.
+   */
+  bool bindUniformBlock(HashedName blockName, unsigned int bindingPoint);
 
   void deleteProgram();
 
+  /**
+   * Looks up an active uniform in the table built at link time. Returns
+   * INVALID_UNIFORM if the program has no such uniform (it may have been
+   * optimized out); setting an invalid handle does nothing.
+   */
+  UniformHandle getUniform(HashedName name) const;
+
   /////////////////////////
   // GETTERS AND SETTERS //
   /////////////////////////
 
   std::string getName() const { return name; }
+  unsigned int getID() const { return ID; }
 
   void setName(const std::string name);
-  void setInteger(const std::string& name, int value);
-  void setVector3f(const std::string& name, const Vector3f& value);
-  void setVector3f(const std::string& name, float x, float y, float z);
-  void setMatrix4x4f(const std::string& name, const Matrix4x4f& value);
+
+  // THE PROGRAM MUST BE IN USE. VALUES EQUAL TO THE LAST UPLOAD ARE SKIPPED
+  void setInteger(UniformHandle uniform, int value);
+  void setVector3f(UniformHandle uniform, const Vector3f& value);
+  void setVector3f(UniformHandle uniform, float x, float y, float z);
+  void setMatrix4x4f(UniformHandle uniform, const Matrix4x4f& value);
+
+  void setInteger(HashedName name, int value) {
+    setInteger(getUniform(name), value);
+  }
+  void setVector3f(HashedName name, const Vector3f& value) {
+    setVector3f(getUniform(name), value);
+  }
+  void setVector3f(HashedName name, float x, float y, float z) {
+    setVector3f(getUniform(name), x, y, z);
+  }
+  void setMatrix4x4f(HashedName name, const Matrix4x4f& value) {
+    setMatrix4x4f(getUniform(name), value);
+  }
 
  private:
+  /**
+   * Active uniform of the default block. Arrays are reflected under their
+   * base name and only their first element is set and cached.
+   */
+  struct Uniform {
+    uint32_t hash;
+    int location;
+    unsigned int type;
+    uint32_t cacheOffset;
+    uint32_t cacheSize;
+  };
+
+  struct UniformBlock {
+    uint32_t hash;
+    unsigned int index;
+    int dataSize;
+  };
+
   unsigned int ID;
 
-  unsigned int vertexShaderID;
-  unsigned int fragmentShaderID;
+  unsigned int vertexShaderID = 0;
+  unsigned int fragmentShaderID = 0;
 
   std::string name;
 
-  void attachShader(const std::string& shaderPath, unsigned int type) const;
+  bool linkPending = false;
+  bool loadedFromCache = false;
+
+  // EMPTY IF THE BINARY CACHE IS NOT USED
+  std::string cachePath;
+  uint64_t cacheKey = 0;
+
+  // SORTED BY HASH
+  std::vector<Uniform> uniforms;
+  std::vector<UniformBlock> uniformBlocks;
+
+  // LAST VALUE UPLOADED FOR EVERY UNIFORM
+  std::vector<uint8_t> uniformValues;
+
+  unsigned int compileShader(const std::string& source,
+                             unsigned int type) const;
+
+  bool loadBinary(const Sources& sources);
+  void saveBinary() const;
+
+  void reflect();
+
+  /**
+   * Stores value in the cache of the uniform. Returns false if the upload
+   * can be skipped because the handle is invalid, the type does not match or
+   * the value did not change.
+   */
+  bool cacheUniform(UniformHandle uniform, const void* value, uint32_t size);
 };
 
 };  // namespace Neu
\ No newline at end of file
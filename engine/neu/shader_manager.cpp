@@ -1,9 +1,171 @@
 #include "shader_manager.h"
 
+#include <cstdio>
+
+#include "application.h"
 #include "core.h"
+#include "utility/thread_pool.h"
 
 using namespace Neu;
 
+void ShaderManager::registerShader(const std::string &name,
+                                   const std::string &vertexShaderPath,
+                                   const std::string &fragmentShaderPath) {
+  const HashedName hashedName = HashedName::fromString(name);
+
+  bool registered = getShader(hashedName) != nullptr;
+
+  for (const PendingShader &pending : pendingShaders)
+    if (pending.hash == hashedName.hash) registered = true;
+
+  // ALSO CATCHES TWO NAMES WITH THE SAME HASH
+  if (registered) {
+    Logger::error("Shader \"%s\" is already registered\n", name.c_str());
+    return;
+  }
+
+  if (!building) {
+    building = true;
+    buildStart = std::chrono::steady_clock::now();
+  }
+
+  pendingShaders.push_back({hashedName.hash, name, {}});
+  submitRead(pendingShaders.back().sources, vertexShaderPath,
+             fragmentShaderPath, true);
+}
+
+void ShaderManager::registerShaderSource(const std::string &name,
+                                         const std::string &vertexShaderPath,
+                                         const std::string &fragmentShaderPath) {
+  const HashedName hashedName = HashedName::fromString(name);
+
+  for (const ShaderSource &source : sources) {
+    if (source.hash == hashedName.hash) {
+      Logger::error("Shader source \"%s\" is already registered\n",
+                    name.c_str());
+      return;
+    }
+  }
+
+  sources.push_back({hashedName.hash, name, {}});
+  submitRead(sources.back().sources, vertexShaderPath, fragmentShaderPath,
+             false);
+}
+
+Shader *ShaderManager::getShader(HashedName name,
+                                 const ShaderVariant &variant) {
+  const uint64_t key = variant.getKey();
+
+  for (const Variant &existing : variants)
+    if (existing.sourceHash == name.hash && existing.key == key)
+      return existing.shader;
+
+  const ShaderSource *source = nullptr;
+
+  for (const ShaderSource &candidate : sources)
+    if (candidate.hash == name.hash) source = &candidate;
+
+  if (!source) {
+    Logger::error("No shader source %08x is registered\n", name.hash);
+    return nullptr;
+  }
+
+  // FIRST USE OF THIS PERMUTATION, BUILD IT NOW FROM THE SOURCES IN MEMORY
+  waitForReads();
+
+  Shader::Sources variantSources = source->sources;
+  Shader::prepareSources(variantSources, variant.getDefines(), cacheDirectory);
+
+  Shader *shader = new Shader(variantSources);
+
+  char variantName[32];
+  snprintf(variantName, sizeof(variantName), "#%llx",
+           static_cast<unsigned long long>(key));
+
+  shader->setName(source->name + variantName);
+  shader->finishLinking();
+
+  for (const auto &binding : uniformBlockBindings)
+    shader->bindUniformBlock(binding.first, binding.second);
+
+  variants.push_back({name.hash, key, shader});
+
+  return shader;
+}
+
+bool ShaderManager::pollShaders() {
+  // THE PROGRAMS ARE CREATED ON THIS THREAD, WHICH OWNS THE CONTEXT
+  if (pendingReads.load() > 0) return false;
+
+  for (PendingShader &pending : pendingShaders) {
+    Shader *shader = new Shader(pending.sources);
+    shader->setName(pending.name);
+
+    shaders.emplace_back(pending.hash, shader);
+  }
+
+  pendingShaders.clear();
+
+  bool done = true;
+
+  for (auto &shader : shaders) {
+    if (shader.second->isLinked()) continue;
+
+    if (shader.second->isReady())
+      shader.second->finishLinking();
+    else
+      done = false;
+  }
+
+  return done;
+}
+
+void ShaderManager::waitForShaders() {
+  waitForReads();
+  pollShaders();
+
+  // THE REST ARE STILL COMPILING, WAITING ON THEM IN ORDER IS AS FAST AS ANY
+  for (auto &shader : shaders) shader.second->finishLinking();
+
+  if (!building) return;
+
+  building = false;
+
+  size_t cachedCount = 0;
+
+  for (auto &shader : shaders)
+    if (shader.second->isLoadedFromCache()) cachedCount++;
+
+  const std::chrono::duration<double, std::milli> duration =
+      std::chrono::steady_clock::now() - buildStart;
+
+  Logger::info("Built %zu shader programs (%zu from cache) in %.1f ms\n",
+               shaders.size(), cachedCount, duration.count());
+}
+
+void ShaderManager::submitRead(Shader::Sources &target,
+                               const std::string &vertexShaderPath,
+                               const std::string &fragmentShaderPath,
+                               bool prepare) {
+  // NEEDS THE CONTEXT, AFTER THE FIRST CALL IT IS SAFE ON ANY THREAD
+  if (prepare) Shader::getDriverString();
+
+  pendingReads++;
+
+  Application::getInstance()->getThreadPool()->submit(
+      [this, &target, vertexShaderPath, fragmentShaderPath, prepare]() {
+        target = Shader::readSources(vertexShaderPath, fragmentShaderPath);
+
+        if (prepare) Shader::prepareSources(target, "", cacheDirectory);
+
+        pendingReads--;
+      });
+}
+
+void ShaderManager::waitForReads() {
+  Application::getInstance()->getThreadPool()->wait(pendingReads);
+}
+
 void ShaderManager::createUniformBuffer(const std::string &blockName,
                                         unsigned int size,
                                         unsigned int bindingPoint) {
@@ -21,6 +183,13 @@ void ShaderManager::createUniformBuffer(const std::string &blockName,
       blockName.c_str(), size, bindingPoint);
 
   uniformBuffers[blockName] = blockID;
+
+  // VARIANTS BUILT LATER PICK THE BINDING UP WHEN THEY ARE LINKED
+  const HashedName hashedName = HashedName::fromString(blockName);
+  uniformBlockBindings.emplace_back(hashedName, bindingPoint);
+
+  for (const Variant &variant : variants)
+    variant.shader->bindUniformBlock(hashedName, bindingPoint);
 }
 
 void ShaderManager::updateUniformBuffer(const std::string &blockName,
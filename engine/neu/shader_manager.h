@@ -1,9 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "shader.h"
+#include "shader_variant.h"
 
 namespace Neu {
 
@@ -18,16 +24,68 @@ class ShaderManager {
     for (auto& shader : shaders) {
       delete shader.second;
     }
+
+    for (auto& variant : variants) {
+      delete variant.shader;
+    }
+  }
+
+  /**
+   * Program binaries are stored in and loaded from this directory. Must be
+   * set before registering shaders; empty disables the cache.
+   */
+  void setCacheDirectory(const std::string& directory) {
+    cacheDirectory = directory;
   }
 
+  /**
+   * Starts building a shader. Its files are read on the thread pool and the
+   * program is handed to the driver by the next pollShaders once all pending
+   * reads are done. It can only be used after pollShaders reported it as
+   * done or waitForShaders returned.
+   */
   void registerShader(const std::string& name,
                       const std::string& vertexShaderPath,
-                      const std::string& fragmentShaderPath) {
-    shaders[name] = new Shader(vertexShaderPath, fragmentShaderPath);
-    shaders[name]->setName(name);
-  }
+                      const std::string& fragmentShaderPath);
+
+  /**
+   * Registers a shader source whose variants are built on demand, see
+   * getShader(HashedName, const ShaderVariant&). The source files are read
+   * on the thread pool, nothing is compiled yet.
+   */
+  void registerShaderSource(const std::string& name,
+                            const std::string& vertexShaderPath,
+                            const std::string& fragmentShaderPath);
 
-  Shader* getShader(std::string name) { return shaders[name]; }
+  /**
+   * Returns the variant of a registered shader source, building it (and
+   * binding the uniform blocks created so far) the first time it is asked
+   * for. Returns nullptr if there is no such source.
+   */
+  Shader* getShader(HashedName name, const ShaderVariant& variant);
+
+  /**
+   * Finishes every shader the driver is done with without blocking. Returns
+   * true once all registered shaders are linked.
+   */
+  bool pollShaders();
+
+  /**
+   * Blocks until all registered shaders are linked and logs how long
+   * building them took.
+   */
+  void waitForShaders();
+
+  /**
+   * Returns the shader registered under name, or nullptr. There are only a
+   * handful of shaders, so a scan of their hashes beats a string map.
+   */
+  Shader* getShader(HashedName name) const {
+    for (const auto& shader : shaders)
+      if (shader.first == name.hash) return shader.second;
+
+    return nullptr;
+  }
 
   void createUniformBuffer(const std::string& blockName, unsigned int size,
                            unsigned int bindingPoint);
@@ -35,7 +93,54 @@ class ShaderManager {
                            unsigned int size, const void* data);
 
  protected:
-  std::unordered_map<std::string, Shader*> shaders;
+  /**
+   * Reads the files of a shader into target on the thread pool. With
+   * prepare, the cached binary of the program without defines is read too.
+   */
+  void submitRead(Shader::Sources& target, const std::string& vertexShaderPath,
+                  const std::string& fragmentShaderPath, bool prepare);
+
+  // WAITS FOR THE READS ON THE THREAD POOL, RUNNING TASKS IN THE MEANTIME
+  void waitForReads();
+
+  std::vector<std::pair<uint32_t, Shader*>> shaders;
+
+  // REGISTERED SHADERS WHOSE FILES ARE STILL BEING READ
+  struct PendingShader {
+    uint32_t hash;
+    std::string name;
+    Shader::Sources sources;
+  };
+
+  struct ShaderSource {
+    uint32_t hash;
+    std::string name;
+
+    // WITHOUT DEFINES, EACH VARIANT ADDS ITS OWN TO A COPY
+    Shader::Sources sources;
+  };
+
+  // DEQUES KEEP THE ELEMENTS IN PLACE WHILE THE READS WRITE INTO THEM
+  std::deque<PendingShader> pendingShaders;
+  std::atomic<int> pendingReads{0};
+
+  struct Variant {
+    uint32_t sourceHash;
+    uint64_t key;
+    Shader* shader;
+  };
+
+  std::deque<ShaderSource> sources;
+  std::vector<Variant> variants;
+
+  // BLOCK NAME -> BINDING POINT, APPLIED TO EVERY NEW VARIANT
+  std::vector<std::pair<HashedName, unsigned int>> uniformBlockBindings;
+
+  std::string cacheDirectory;
+
+  // SET WHEN THE FIRST SHADER OF A BATCH IS REGISTERED
+  bool building = false;
+  std::chrono::steady_clock::time_point buildStart;
   std::unordered_map<std::string, unsigned int> uniformBuffers;
 };
 
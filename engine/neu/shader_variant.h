@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Neu {
+
+/**
+ * Optional features of a shader source. Every set flag is injected as a
+ * #define of the same name (without the SHADER_FEATURE_ prefix).
+ */
+enum ShaderFeature : uint32_t {
+  SHADER_FEATURE_INSTANCED = 1 << 0,
+  SHADER_FEATURE_VERTEX_COLORS = 1 << 1,
+  SHADER_FEATURE_SHADOWS = 1 << 2,
+  SHADER_FEATURE_CLUSTERED = 1 << 3,
+
+  SHADER_FEATURE_COUNT = 4
+};
+
+/**
+ * Selects one permutation of a shader source, see
+ * ShaderManager::getShader(HashedName, const ShaderVariant&).
+ */
+struct ShaderVariant {
+  uint32_t features = 0;
+
+  // INJECTED AS MAX_LIGHTS, 0 KEEPS THE DEFAULT OF THE SOURCE
+  uint32_t lightCount = 0;
+
+  uint64_t getKey() const {
+    return (static_cast<uint64_t>(lightCount) << 32) | features;
+  }
+
+  /**
+   * The lines inserted after the #version directive of both stages.
+   */
+  std::string getDefines() const {
+    static const char* const featureNames[SHADER_FEATURE_COUNT] = {
+        "INSTANCED", "VERTEX_COLORS", "SHADOWS", "CLUSTERED"};
+
+    std::string defines;
+
+    for (uint32_t i = 0; i < SHADER_FEATURE_COUNT; i++)
+      if (features & (1u << i))
+        defines += std::string("#define ") + featureNames[i] + "\n";
+
+    if (lightCount > 0)
+      defines += "#define MAX_LIGHTS " + std::to_string(lightCount) + "\n";
+
+    return defines;
+  }
+};
+
+}  // namespace Neu
@@ -1,17 +1,19 @@
 #include "physics_system.h"
 
 #include "application.h"
+#include "components/component_manager.h"
 #include "components/rigid_body.h"
 #include "components/transform.h"
 #include "input_manager.h"
 #include "scene/game_object.h"
+#include "utility/job_system.h"
 #include "utility/logger.h"
 
 // clang-format off
 #include <Jolt/Jolt.h>
 
 #include <Jolt/Core/Factory.h>
-#include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Core/JobSystemWithBarrier.h>
 #include <Jolt/Core/TempAllocator.h>
 #include <Jolt/Physics/Body/BodyActivationListener.h>
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
@@ -68,12 +70,9 @@ void Neu::PhysicsSystem::setup() {
   // use TempAllocatorMalloc to fall back to malloc / free.
   temp_allocator = new TempAllocatorImpl(10 * 1024 * 1024);  // 10 MB
 
-  // We need a job system that will execute physics jobs on multiple threads.
-  // Typically you would implement the JobSystem interface yourself and let Jolt
-  // Physics run on top of your own job scheduler. JobSystemThreadPool is an
-  // example implementation.
-  job_system = new JobSystemThreadPool(cMaxPhysicsJobs, cMaxPhysicsBarriers,
-                                       thread::hardware_concurrency() - 1);
+  // PHYSICS JOBS RUN ON THE ENGINE THREAD POOL
+  job_system = new Neu::JobSystem(Application::getInstance()->getThreadPool(),
+                                  cMaxPhysicsJobs, cMaxPhysicsBarriers);
 
   // This is the max amount of rigid bodies that you can add to the physics
   // system. If you try to add more you'll get an error. Note: This value is low
@@ -184,6 +183,12 @@ void Neu::PhysicsSystem::addBody(GameObject* gameObject) {
 
     bodySettings.mFriction = 0.6;
 
+    // BOTH INTERPOLATION STATES START AT THE SPAWN POSE
+    rigidBodyComponent.currentPosition = transformComponent.position;
+    rigidBodyComponent.currentRotation = bodySettings.mRotation;
+    rigidBodyComponent.previousPosition = rigidBodyComponent.currentPosition;
+    rigidBodyComponent.previousRotation = rigidBodyComponent.currentRotation;
+
     rigidBodyComponent.setBodyID(
         bodyInterface.CreateAndAddBody(bodySettings, EActivation::Activate));
   }
@@ -200,7 +205,7 @@ void Neu::PhysicsSystem::optimize() {
   physicsSystem.OptimizeBroadPhase();
 }
 
-void Neu::PhysicsSystem::update(std::vector<GameObject*>& gameObjects,
+void Neu::PhysicsSystem::update(ComponentManager& componentManager,
                                 float deltaTime) {
   NEU_PROFILE_FUNCTION;
 
@@ -208,44 +213,66 @@ void Neu::PhysicsSystem::update(std::vector<GameObject*>& gameObjects,
 
   physicsSystem.Update(deltaTime, collisionSteps, temp_allocator, job_system);
 
-  for (GameObject* gameObject : gameObjects) {
-    if (gameObject->hasComponent<RigidBodyComponent>() &&
-        gameObject->hasComponent<TransformComponent>()) {
-      RigidBodyComponent& rigidBodyComponent =
-          gameObject->getComponent<RigidBodyComponent>();
-      TransformComponent& transformComponent =
-          gameObject->getComponent<TransformComponent>();
-
-      if (bodyInterface.IsActive(rigidBodyComponent.getBodyID())) {
-        RVec3 position = bodyInterface.GetCenterOfMassPosition(
-            rigidBodyComponent.getBodyID());
-        Vec3 linearVelocity =
-            bodyInterface.GetLinearVelocity(rigidBodyComponent.getBodyID());
-        Vec3 rotation =
-            bodyInterface.GetRotation(rigidBodyComponent.getBodyID())
-                .GetEulerAngles();
-
-        transformComponent.position =
-            Vector3f(position.GetX(), position.GetY(), position.GetZ());
-        transformComponent.rotation =
-            Vector3f(rotation.GetX(), rotation.GetY(), rotation.GetZ());
-
-        rigidBodyComponent.setlinearVelocity(Vector3f(linearVelocity.GetX(),
-                                                      linearVelocity.GetY(),
-                                                      linearVelocity.GetZ()));
-      }
+  for (auto [entity, rigidBodyComponent] :
+       componentManager.view<RigidBodyComponent>()) {
+    rigidBodyComponent.previousPosition = rigidBodyComponent.currentPosition;
+    rigidBodyComponent.previousRotation = rigidBodyComponent.currentRotation;
+
+    if (bodyInterface.IsActive(rigidBodyComponent.getBodyID())) {
+      RVec3 position =
+          bodyInterface.GetCenterOfMassPosition(rigidBodyComponent.getBodyID());
+      Vec3 linearVelocity =
+          bodyInterface.GetLinearVelocity(rigidBodyComponent.getBodyID());
+
+      rigidBodyComponent.currentPosition =
+          Vector3f(position.GetX(), position.GetY(), position.GetZ());
+      rigidBodyComponent.currentRotation =
+          bodyInterface.GetRotation(rigidBodyComponent.getBodyID());
+      rigidBodyComponent.interpolating = true;
+
+      rigidBodyComponent.setlinearVelocity(Vector3f(
+          linearVelocity.GetX(), linearVelocity.GetY(), linearVelocity.GetZ()));
     }
   }
+}
+
+void Neu::PhysicsSystem::interpolate(ComponentManager& componentManager,
+                                     float alpha) {
+  NEU_PROFILE_FUNCTION;
 
-  // DEBUG RENDERING
+  for (auto [entity, rigidBodyComponent, transformComponent] :
+       componentManager.view<RigidBodyComponent, TransformComponent>()) {
+    // SLEEPING BODIES KEEP THEIR TRANSFORM (AND THEIR CACHED MATRICES)
+    if (!rigidBodyComponent.interpolating) continue;
 
-  NEU_PROFILE_START_CUSTOM(DebugRender);
+    const Vector3f& previous = rigidBodyComponent.previousPosition;
+    const Vector3f& current = rigidBodyComponent.currentPosition;
+
+    Vec3 rotation = rigidBodyComponent.previousRotation
+                        .SLERP(rigidBodyComponent.currentRotation, alpha)
+                        .GetEulerAngles();
+
+    transformComponent.position = previous + (current - previous) * alpha;
+    transformComponent.rotation =
+        Vector3f(rotation.GetX(), rotation.GetY(), rotation.GetZ());
+    transformComponent.dirty = true;
+
+    // THE BODY CAME TO REST, THIS WAS ITS FINAL POSE
+    if (previous == current &&
+        rigidBodyComponent.previousRotation ==
+            rigidBodyComponent.currentRotation)
+      rigidBodyComponent.interpolating = false;
+  }
+}
+
+void Neu::PhysicsSystem::drawDebug(DebugDraw& debugDraw) {
+  NEU_PROFILE_FUNCTION;
+
+  physicsDebugRenderer->setDebugDraw(&debugDraw);
 
   JPH::BodyManager::DrawSettings drawSettings;
   drawSettings.mDrawShape = false;
   drawSettings.mDrawBoundingBox = true;
   drawSettings.mDrawCenterOfMassTransform = true;
   physicsSystem.DrawBodies(drawSettings, physicsDebugRenderer);
-
-  NEU_PROFILE_STOP_CUSTOM(DebugRender);
 }
\ No newline at end of file
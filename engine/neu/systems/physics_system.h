@@ -3,7 +3,6 @@
 // clang-format off
 #include <Jolt/Jolt.h>
 
-#include <Jolt/Core/JobSystemThreadPool.h>
 #include <Jolt/Physics/PhysicsScene.h>
 #include <Jolt/Physics/PhysicsSystem.h>
 // clang-format on
@@ -100,6 +99,9 @@ class ObjectVsBroadPhaseLayerFilterImpl : public ObjectVsBroadPhaseLayerFilter {
 namespace Neu {
 
 class GameObject;
+class ComponentManager;
+class JobSystem;
+class DebugDraw;
 
 class PhysicsSystem {
  public:
@@ -109,7 +111,24 @@ class PhysicsSystem {
   void addBody(GameObject* gameObject);
 
   void optimize();
-  void update(std::vector<GameObject*>& gameObjects, float deltaTime);
+
+  /**
+   * Advances the simulation by one fixed step and stores the new body states
+   * in the rigid body components. Transforms are left to interpolate().
+   */
+  void update(ComponentManager& componentManager, float deltaTime);
+
+  /**
+   * Writes the pose between the last two fixed steps into the transforms of
+   * the moving bodies, alpha = 0 being the previous step.
+   */
+  void interpolate(ComponentManager& componentManager, float alpha);
+
+  /**
+   * Adds the body bounds to the debug draw batch. Must run on the main thread
+   * (the batch is not thread-safe).
+   */
+  void drawDebug(DebugDraw& debugDraw);
 
  private:
   // Create mapping table from object layer to broadphase layer
@@ -134,7 +153,7 @@ class PhysicsSystem {
   ObjectLayerPairFilterImpl object_vs_object_layer_filter;
 
   TempAllocatorImpl* temp_allocator;
-  JobSystemThreadPool* job_system;
+  Neu::JobSystem* job_system;
 
   JPH::PhysicsSystem physicsSystem;
   BodyID sphere_id;
@@ -0,0 +1,65 @@
+#include "system_scheduler.h"
+
+#include <atomic>
+#include <memory>
+
+#include "utility/profiler.h"
+#include "utility/thread_pool.h"
+
+using namespace Neu;
+
+void SystemScheduler::addSystem(const std::string& name,
+                                const SystemAccess& access,
+                                SystemFunction update) {
+  systems.push_back({name, access, update});
+}
+
+void SystemScheduler::buildGraph() {
+  dependents.assign(systems.size(), {});
+  dependencyCounts.assign(systems.size(), 0);
+
+  // EARLIER SYSTEMS RUN FIRST WHEN TWO SYSTEMS CONFLICT
+  for (size_t later = 0; later < systems.size(); later++) {
+    for (size_t earlier = 0; earlier < later; earlier++) {
+      if (systems[earlier].access.conflictsWith(systems[later].access)) {
+        dependents[earlier].push_back(later);
+        dependencyCounts[later]++;
+      }
+    }
+  }
+}
+
+void SystemScheduler::run(float deltaTime) {
+  NEU_PROFILE_FUNCTION;
+
+  if (systems.empty()) return;
+
+  buildGraph();
+
+  std::unique_ptr<std::atomic<int>[]> pending(
+      new std::atomic<int>[systems.size()]);
+  for (size_t i = 0; i < systems.size(); i++) pending[i] = dependencyCounts[i];
+
+  std::atomic<int> remaining(static_cast<int>(systems.size()));
+
+  std::function<void(size_t)> schedule = [&](size_t index) {
+    threadPool->submit([&, index]() {
+      {
+        // A ROOT SECTION OF WHICHEVER THREAD RUNS THE SYSTEM
+        ProfilerAgent systemProfilerAgent(systems[index].name);
+        systems[index].update(deltaTime);
+      }
+
+      // RELEASE SYSTEMS THAT WERE WAITING ON THIS ONE
+      for (size_t dependent : dependents[index])
+        if (--pending[dependent] == 0) schedule(dependent);
+
+      remaining--;
+    });
+  };
+
+  for (size_t i = 0; i < systems.size(); i++)
+    if (dependencyCounts[i] == 0) schedule(i);
+
+  threadPool->wait(remaining);
+}
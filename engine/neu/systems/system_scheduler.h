@@ -0,0 +1,77 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "components/component_type.h"
+
+namespace Neu {
+
+class ThreadPool;
+
+/**
+ * The components a system reads and writes. Two systems conflict, and must
+ * not run at the same time, if either one writes a component the other one
+ * touches.
+ */
+struct SystemAccess {
+  ComponentMask reads;
+  ComponentMask writes;
+
+  template <typename... Ts>
+  SystemAccess& read() {
+    (reads.set(componentTypeID<Ts>), ...);
+    return *this;
+  }
+
+  template <typename... Ts>
+  SystemAccess& write() {
+    (writes.set(componentTypeID<Ts>), ...);
+    return *this;
+  }
+
+  bool conflictsWith(const SystemAccess& other) const {
+    return (writes & (other.reads | other.writes)).any() ||
+           (other.writes & reads).any();
+  }
+};
+
+/**
+ * Runs the registered systems on the thread pool. Every frame a dependency
+ * graph is built from the declared component access: conflicting systems run
+ * in registration order, all other systems run concurrently.
+ */
+class SystemScheduler {
+ public:
+  using SystemFunction = std::function<void(float)>;
+
+  SystemScheduler(ThreadPool* threadPool) : threadPool(threadPool) {}
+
+  void addSystem(const std::string& name, const SystemAccess& access,
+                 SystemFunction update);
+
+  /**
+   * Runs every system once and returns when all of them have finished.
+   */
+  void run(float deltaTime);
+
+ private:
+  struct SystemEntry {
+    std::string name;
+    SystemAccess access;
+    SystemFunction update;
+  };
+
+  void buildGraph();
+
+  ThreadPool* threadPool;
+
+  std::vector<SystemEntry> systems;
+
+  // REBUILT EVERY FRAME
+  std::vector<std::vector<size_t>> dependents;
+  std::vector<int> dependencyCounts;
+};
+
+}  // namespace Neu
@@ -1,21 +1,321 @@
 #include "transform.h"
 
+#include <algorithm>
+#include <vector>
+
+#include "components/component_manager.h"
+#include "components/mesh.h"
 #include "components/transform.h"
-#include "scene/game_object.h"
+#include "utility/logger.h"
 #include "utility/profiler.h"
+#include "utility/simd.h"
+#include "utility/thread_pool.h"
 
 using namespace Neu;
 
-void TransformSystem::update(std::vector<GameObject *> &gameObjects) {
+void TransformSystem::update(ComponentManager &componentManager,
+                             ThreadPool &threadPool) {
   NEU_PROFILE_FUNCTION;
 
-  for (auto *gameObject : gameObjects) {
-    if (gameObject->hasComponent<TransformComponent>()) {
-      TransformComponent &transform =
-          gameObject->getComponent<TransformComponent>();
+  frame++;
+
+  auto view = componentManager.view<TransformComponent>();
+
+  /////////////////////////////////
+  // LOCAL MATRICES (DIRTY ONLY) //
+  /////////////////////////////////
+
+  // BLOCKS ARE DISJOINT, SO EACH ONE CAN BE UPDATED ON ITS OWN THREAD
+  threadPool.parallelFor(view.getBlockCount(), [this, &view](size_t block) {
+    thread_local std::vector<TransformComponent *> transforms;
+    transforms.clear();
+
+    view.eachInBlock(block, [](Entity, TransformComponent &transform) {
+      if (transform.dirty) transforms.push_back(&transform);
+    });
+
+    updateTransforms(transforms.data(), transforms.size());
 
-      transform.transform = createTransformMatrix(
-          transform.position, transform.rotation, transform.scale);
+    for (TransformComponent *transform : transforms) {
+      transform->dirty = false;
+      transform->updatedFrame = frame;
+
+      // ROOTS HAVE NO PARENT TO PROPAGATE FROM
+      if (transform->parent == NULL_ENTITY)
+        transform->transform = transform->localTransform;
     }
+  });
+
+  ///////////////////////////
+  // HIERARCHY PROPAGATION //
+  ///////////////////////////
+
+  if (hierarchyChanged) buildHierarchyOrder(componentManager);
+
+  for (Entity entity : hierarchyOrder) {
+    TransformComponent *transform =
+        componentManager.getComponent<TransformComponent>(entity);
+    if (!transform) continue;
+
+    TransformComponent *parent =
+        componentManager.getComponent<TransformComponent>(transform->parent);
+
+    // THE PARENT WAS DESTROYED, TREAT AS A ROOT
+    if (!parent) {
+      if (transform->updatedFrame == frame)
+        transform->transform = transform->localTransform;
+      continue;
+    }
+
+    if (transform->updatedFrame != frame && parent->updatedFrame != frame)
+      continue;
+
+    transform->transform = parent->transform * transform->localTransform;
+    transform->updatedFrame = frame;
+  }
+
+  updateSpatialTree(componentManager);
+}
+
+void TransformSystem::setParent(ComponentManager &componentManager,
+                                Entity child, Entity parent) {
+  TransformComponent *childTransform =
+      componentManager.getComponent<TransformComponent>(child);
+
+  if (!childTransform) {
+    Logger::error("Entity %u has no transform to parent\n", child);
+    return;
   }
-}
\ No newline at end of file
+
+  if (parent != NULL_ENTITY) {
+    if (!componentManager.hasComponent<TransformComponent>(parent)) {
+      Logger::error("Parent entity %u has no transform\n", parent);
+      return;
+    }
+
+    // REFUSE TO CREATE A CYCLE
+    for (Entity ancestor = parent; ancestor != NULL_ENTITY;) {
+      if (ancestor == child) {
+        Logger::error("Entity %u cannot be parented to its descendant %u\n",
+                      child, parent);
+        return;
+      }
+
+      TransformComponent *ancestorTransform =
+          componentManager.getComponent<TransformComponent>(ancestor);
+      ancestor = ancestorTransform ? ancestorTransform->parent : NULL_ENTITY;
+    }
+  }
+
+  ////////////////////////////
+  // DETACH FROM OLD PARENT //
+  ////////////////////////////
+
+  if (TransformComponent *oldParent =
+          componentManager.getComponent<TransformComponent>(
+              childTransform->parent)) {
+    auto &siblings = oldParent->children;
+    siblings.erase(std::remove(siblings.begin(), siblings.end(), child),
+                   siblings.end());
+  }
+
+  childTransform->parent = parent;
+
+  if (parent != NULL_ENTITY)
+    componentManager.getComponent<TransformComponent>(parent)
+        ->children.push_back(child);
+
+  childTransform->dirty = true;
+  hierarchyChanged = true;
+}
+
+void TransformSystem::buildHierarchyOrder(ComponentManager &componentManager) {
+  hierarchyOrder.clear();
+
+  // BREADTH-FIRST FROM EVERY ROOT, SO DEPTH NEVER DECREASES ALONG THE ORDER
+  for (auto [entity, transform] :
+       componentManager.view<TransformComponent>()) {
+    if (transform.parent != NULL_ENTITY) continue;
+
+    size_t start = hierarchyOrder.size();
+    hierarchyOrder.insert(hierarchyOrder.end(), transform.children.begin(),
+                          transform.children.end());
+
+    for (size_t i = start; i < hierarchyOrder.size(); i++) {
+      TransformComponent *child =
+          componentManager.getComponent<TransformComponent>(hierarchyOrder[i]);
+      if (!child) continue;
+
+      hierarchyOrder.insert(hierarchyOrder.end(), child->children.begin(),
+                            child->children.end());
+    }
+  }
+
+  hierarchyChanged = false;
+}
+
+void TransformSystem::updateSpatialTree(ComponentManager &componentManager) {
+  NEU_PROFILE_FUNCTION;
+
+  size_t meshCount = 0;
+
+  for (auto [entity, transform, mesh] :
+       componentManager.view<TransformComponent, MeshComponent>()) {
+    if (!mesh.mesh || !mesh.mesh->getBounds().isValid()) continue;
+
+    meshCount++;
+
+    if (entity >= proxies.size())
+      proxies.resize(entity + 1, DynamicAABBTree::NULL_NODE);
+
+    int32_t &proxy = proxies[entity];
+
+    // STATIC ENTITIES KEEP THEIR LEAF UNTOUCHED, DYNAMIC MESHES MAY HAVE
+    // CHANGED THEIR BOUNDS
+    if (proxy != DynamicAABBTree::NULL_NODE &&
+        transform.updatedFrame != frame && !mesh.mesh->isDynamic())
+      continue;
+
+    AABB bounds = mesh.mesh->getBounds().transformed(transform.transform);
+
+    if (proxy == DynamicAABBTree::NULL_NODE)
+      proxy = spatialTree.createProxy(bounds, entity);
+    else
+      spatialTree.moveProxy(proxy, bounds);
+  }
+
+  // SOME ENTITIES LOST THEIR TRANSFORM OR MESH, REMOVE THEIR LEAVES
+  if (meshCount == spatialTree.getProxyCount()) return;
+
+  for (Entity entity = 0; entity < proxies.size(); entity++) {
+    if (proxies[entity] == DynamicAABBTree::NULL_NODE) continue;
+
+    MeshComponent *mesh = componentManager.getComponent<MeshComponent>(entity);
+    if (mesh && mesh->mesh && mesh->mesh->getBounds().isValid() &&
+        componentManager.hasComponent<TransformComponent>(entity))
+      continue;
+
+    spatialTree.destroyProxy(proxies[entity]);
+    proxies[entity] = DynamicAABBTree::NULL_NODE;
+  }
+}
+
+void TransformSystem::updateTransformsScalar(
+    TransformComponent *const *transforms, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    TransformComponent &transform = *transforms[i];
+    transform.localTransform = createTransformMatrix(
+        transform.position, transform.rotation, transform.scale);
+  }
+}
+
+#ifdef NEU_SIMD_SSE2
+
+/**
+ * Builds T * Rz * Ry * Rx * S for S::width transforms at once. Lanes past
+ * count are padded and not written back.
+ */
+template <typename S>
+static void updateTransformBatch(TransformComponent *const *transforms,
+                                 size_t count) {
+  using Float = typename S::Float;
+  constexpr int width = S::width;
+
+  /////////////////////
+  // GATHER INTO SOA //
+  /////////////////////
+
+  // POSITION XYZ, ROTATION XYZ, SCALE XYZ
+  alignas(32) float input[9][width];
+
+  for (int lane = 0; lane < width; lane++) {
+    const TransformComponent &transform =
+        *transforms[lane < static_cast<int>(count) ? lane : 0];
+
+    input[0][lane] = transform.position.x;
+    input[1][lane] = transform.position.y;
+    input[2][lane] = transform.position.z;
+    input[3][lane] = transform.rotation.x;
+    input[4][lane] = transform.rotation.y;
+    input[5][lane] = transform.rotation.z;
+    input[6][lane] = transform.scale.x;
+    input[7][lane] = transform.scale.y;
+    input[8][lane] = transform.scale.z;
+  }
+
+  Float sinX, cosX, sinY, cosY, sinZ, cosZ;
+  simdSinCos<S>(S::load(input[3]), sinX, cosX);
+  simdSinCos<S>(S::load(input[4]), sinY, cosY);
+  simdSinCos<S>(S::load(input[5]), sinZ, cosZ);
+
+  Float scaleX = S::load(input[6]);
+  Float scaleY = S::load(input[7]);
+  Float scaleZ = S::load(input[8]);
+
+  ////////////////////
+  // ROTATION TERMS //
+  ////////////////////
+
+  Float sinXsinY = S::mul(sinX, sinY);
+  Float cosXsinY = S::mul(cosX, sinY);
+
+  // ROWS OF RZ * RY * RX
+  Float r00 = S::mul(cosY, cosZ);
+  Float r01 = S::sub(S::mul(sinXsinY, cosZ), S::mul(cosX, sinZ));
+  Float r02 = S::add(S::mul(cosXsinY, cosZ), S::mul(sinX, sinZ));
+  Float r10 = S::mul(cosY, sinZ);
+  Float r11 = S::add(S::mul(sinXsinY, sinZ), S::mul(cosX, cosZ));
+  Float r12 = S::sub(S::mul(cosXsinY, sinZ), S::mul(sinX, cosZ));
+  Float r20 = S::sub(S::set1(0.0f), sinY);
+  Float r21 = S::mul(sinX, cosY);
+  Float r22 = S::mul(cosX, cosY);
+
+  ///////////////////////////////////
+  // SCATTER COLUMN-MAJOR MATRICES //
+  ///////////////////////////////////
+
+  // INDEXED BY COLUMN * 3 + ROW (THE BOTTOM ROW IS CONSTANT)
+  alignas(32) float output[12][width];
+
+  S::store(output[0], S::mul(r00, scaleX));
+  S::store(output[1], S::mul(r10, scaleX));
+  S::store(output[2], S::mul(r20, scaleX));
+  S::store(output[3], S::mul(r01, scaleY));
+  S::store(output[4], S::mul(r11, scaleY));
+  S::store(output[5], S::mul(r21, scaleY));
+  S::store(output[6], S::mul(r02, scaleZ));
+  S::store(output[7], S::mul(r12, scaleZ));
+  S::store(output[8], S::mul(r22, scaleZ));
+
+  for (int lane = 0; lane < static_cast<int>(count) && lane < width; lane++) {
+    Matrix4x4f &matrix = transforms[lane]->localTransform;
+
+    for (int column = 0; column < 3; column++) {
+      matrix(0, column) = output[column * 3 + 0][lane];
+      matrix(1, column) = output[column * 3 + 1][lane];
+      matrix(2, column) = output[column * 3 + 2][lane];
+      matrix(3, column) = 0.0f;
+    }
+
+    matrix(0, 3) = input[0][lane];
+    matrix(1, 3) = input[1][lane];
+    matrix(2, 3) = input[2][lane];
+    matrix(3, 3) = 1.0f;
+  }
+}
+
+void TransformSystem::updateTransforms(TransformComponent *const *transforms,
+                                       size_t count) {
+  for (size_t i = 0; i < count; i += SimdBest::width)
+    updateTransformBatch<SimdBest>(transforms + i, count - i);
+}
+
+#else
+
+// NO SIMD AVAILABLE, FALL BACK TO THE REFERENCE PATH
+void TransformSystem::updateTransforms(TransformComponent *const *transforms,
+                                       size_t count) {
+  updateTransformsScalar(transforms, count);
+}
+
+#endif
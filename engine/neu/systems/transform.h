@@ -1,13 +1,70 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
+#include "components/component_type.h"
+#include "utility/aabb_tree.h"
+
 namespace Neu {
-class GameObject;
+class ComponentManager;
+class ThreadPool;
+class TransformComponent;
 
+/**
+ * Keeps the local and world matrices of every transform up to date. Only
+ * dirty transforms have their local matrix rebuilt. World matrices are
+ * propagated down the hierarchy in parent-before-child order, so a subtree is
+ * only touched when it or one of its ancestors changed. Entities with a mesh
+ * whose world matrix changed are then moved in the scene's spatial tree.
+ */
 class TransformSystem {
  public:
-  void update(std::vector<GameObject*>& gameObjects);
+  void update(ComponentManager& componentManager, ThreadPool& threadPool);
+
+  /**
+   * Attaches child to parent (or detaches it if parent is NULL_ENTITY).
+   */
+  void setParent(ComponentManager& componentManager, Entity child,
+                 Entity parent);
+
+  /**
+   * Bounding volume hierarchy over the world bounds of every entity with a
+   * transform and a mesh, for culling, picking and gameplay queries. Only
+   * valid between updates.
+   */
+  const DynamicAABBTree& getSpatialTree() const { return spatialTree; }
+
+  /**
+   * Rebuilds the local matrices of the given transforms. Positions, rotations
+   * and scales are gathered into SoA batches and converted with SSE (4 lanes)
+   * or AVX2 (8 lanes), depending on the instruction set the engine is built
+   * for.
+   */
+  static void updateTransforms(TransformComponent* const* transforms,
+                               size_t count);
+
+  /**
+   * Reference implementation of updateTransforms using the scalar
+   * createTransformMatrix.
+   */
+  static void updateTransformsScalar(TransformComponent* const* transforms,
+                                     size_t count);
+
+ private:
+  void buildHierarchyOrder(ComponentManager& componentManager);
+  void updateSpatialTree(ComponentManager& componentManager);
+
+  // ENTITIES WITH A PARENT, SORTED SO PARENTS COME BEFORE THEIR CHILDREN
+  std::vector<Entity> hierarchyOrder;
+  bool hierarchyChanged = true;
+
+  DynamicAABBTree spatialTree;
+  std::vector<int32_t> proxies;  // ENTITY -> PROXY
+
+  // STARTS AT 1 SO NEW TRANSFORMS (updatedFrame = 0) NEVER LOOK UPDATED
+  uint32_t frame = 1;
 };
 
-}  // namespace Neu
\ No newline at end of file
+}  // namespace Neu
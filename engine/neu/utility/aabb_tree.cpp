@@ -0,0 +1,247 @@
+#include "aabb_tree.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Neu;
+
+static AABB fatten(const AABB& box) {
+  const Vector3f margin(AABB_TREE_MARGIN, AABB_TREE_MARGIN, AABB_TREE_MARGIN);
+
+  AABB fatBox;
+  fatBox.min = box.min - margin;
+  fatBox.max = box.max + margin;
+  return fatBox;
+}
+
+int32_t DynamicAABBTree::createProxy(const AABB& box, Entity entity) {
+  int32_t proxy = allocateNode();
+
+  nodes[proxy].box = fatten(box);
+  nodes[proxy].entity = entity;
+  nodes[proxy].height = 0;
+
+  insertLeaf(proxy);
+  proxyCount++;
+
+  return proxy;
+}
+
+void DynamicAABBTree::destroyProxy(int32_t proxy) {
+  assert(proxy >= 0 && proxy < static_cast<int32_t>(nodes.size()));
+  assert(nodes[proxy].isLeaf());
+
+  removeLeaf(proxy);
+  freeNode(proxy);
+  proxyCount--;
+}
+
+bool DynamicAABBTree::moveProxy(int32_t proxy, const AABB& box) {
+  assert(proxy >= 0 && proxy < static_cast<int32_t>(nodes.size()));
+  assert(nodes[proxy].isLeaf());
+
+  if (nodes[proxy].box.contains(box)) return false;
+
+  removeLeaf(proxy);
+  nodes[proxy].box = fatten(box);
+  insertLeaf(proxy);
+
+  return true;
+}
+
+/////////////////////
+// NODE ALLOCATION //
+/////////////////////
+
+int32_t DynamicAABBTree::allocateNode() {
+  if (freeList == NULL_NODE) {
+    nodes.emplace_back();
+    return static_cast<int32_t>(nodes.size() - 1);
+  }
+
+  int32_t node = freeList;
+  freeList = nodes[node].parent;
+
+  nodes[node] = Node();
+  return node;
+}
+
+void DynamicAABBTree::freeNode(int32_t node) {
+  nodes[node].parent = freeList;
+  nodes[node].height = -1;
+  freeList = node;
+}
+
+///////////////////////
+// INSERT AND REMOVE //
+///////////////////////
+
+void DynamicAABBTree::insertLeaf(int32_t leaf) {
+  if (root == NULL_NODE) {
+    root = leaf;
+    nodes[root].parent = NULL_NODE;
+    return;
+  }
+
+  // DESCEND TOWARDS THE SIBLING THAT ADDS THE LEAST SURFACE AREA
+  const AABB leafBox = nodes[leaf].box;
+  int32_t index = root;
+
+  while (!nodes[index].isLeaf()) {
+    int32_t child1 = nodes[index].child1;
+    int32_t child2 = nodes[index].child2;
+
+    float area = nodes[index].box.getSurfaceArea();
+    float combinedArea = AABB::merge(nodes[index].box, leafBox).getSurfaceArea();
+
+    // COST OF MAKING A NEW PARENT FOR THIS NODE AND THE LEAF
+    float cost = 2.0f * combinedArea;
+
+    // MINIMUM COST OF PUSHING THE LEAF FURTHER DOWN
+    float inheritanceCost = 2.0f * (combinedArea - area);
+
+    auto descendCost = [&](int32_t child) {
+      float childArea = AABB::merge(leafBox, nodes[child].box).getSurfaceArea();
+      if (nodes[child].isLeaf()) return childArea + inheritanceCost;
+      return childArea - nodes[child].box.getSurfaceArea() + inheritanceCost;
+    };
+
+    float cost1 = descendCost(child1);
+    float cost2 = descendCost(child2);
+
+    if (cost < cost1 && cost < cost2) break;
+
+    index = cost1 < cost2 ? child1 : child2;
+  }
+
+  int32_t sibling = index;
+
+  // CREATE A NEW PARENT FOR THE SIBLING AND THE LEAF
+  int32_t oldParent = nodes[sibling].parent;
+  int32_t newParent = allocateNode();
+
+  nodes[newParent].parent = oldParent;
+  nodes[newParent].box = AABB::merge(leafBox, nodes[sibling].box);
+  nodes[newParent].height = nodes[sibling].height + 1;
+  nodes[newParent].child1 = sibling;
+  nodes[newParent].child2 = leaf;
+  nodes[sibling].parent = newParent;
+  nodes[leaf].parent = newParent;
+
+  if (oldParent == NULL_NODE) {
+    root = newParent;
+  } else if (nodes[oldParent].child1 == sibling) {
+    nodes[oldParent].child1 = newParent;
+  } else {
+    nodes[oldParent].child2 = newParent;
+  }
+
+  // REFIT AND REBALANCE THE ANCESTORS
+  for (index = nodes[leaf].parent; index != NULL_NODE;
+       index = nodes[index].parent) {
+    index = balance(index);
+
+    int32_t child1 = nodes[index].child1;
+    int32_t child2 = nodes[index].child2;
+
+    nodes[index].height =
+        1 + std::max(nodes[child1].height, nodes[child2].height);
+    nodes[index].box = AABB::merge(nodes[child1].box, nodes[child2].box);
+  }
+}
+
+void DynamicAABBTree::removeLeaf(int32_t leaf) {
+  if (leaf == root) {
+    root = NULL_NODE;
+    return;
+  }
+
+  int32_t parent = nodes[leaf].parent;
+  int32_t grandParent = nodes[parent].parent;
+  int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2
+                                                 : nodes[parent].child1;
+
+  freeNode(parent);
+
+  if (grandParent == NULL_NODE) {
+    root = sibling;
+    nodes[sibling].parent = NULL_NODE;
+    return;
+  }
+
+  // THE SIBLING TAKES THE PLACE OF THE PARENT
+  if (nodes[grandParent].child1 == parent)
+    nodes[grandParent].child1 = sibling;
+  else
+    nodes[grandParent].child2 = sibling;
+
+  nodes[sibling].parent = grandParent;
+
+  for (int32_t index = grandParent; index != NULL_NODE;
+       index = nodes[index].parent) {
+    index = balance(index);
+
+    int32_t child1 = nodes[index].child1;
+    int32_t child2 = nodes[index].child2;
+
+    nodes[index].box = AABB::merge(nodes[child1].box, nodes[child2].box);
+    nodes[index].height =
+        1 + std::max(nodes[child1].height, nodes[child2].height);
+  }
+}
+
+///////////////
+// BALANCING //
+///////////////
+
+int32_t DynamicAABBTree::balance(int32_t a) {
+  if (nodes[a].isLeaf() || nodes[a].height < 2) return a;
+
+  int32_t b = nodes[a].child1;
+  int32_t c = nodes[a].child2;
+
+  int32_t heightDifference = nodes[c].height - nodes[b].height;
+
+  if (heightDifference > 1 || heightDifference < -1) {
+    // PROMOTE THE TALLER CHILD (HIGH) AND MOVE A UNDER IT
+    bool rotateRight = heightDifference > 1;
+    int32_t high = rotateRight ? c : b;
+    int32_t low = rotateRight ? b : c;
+
+    int32_t f = nodes[high].child1;
+    int32_t g = nodes[high].child2;
+
+    nodes[high].child1 = a;
+    nodes[high].parent = nodes[a].parent;
+    nodes[a].parent = high;
+
+    if (nodes[high].parent == NULL_NODE) {
+      root = high;
+    } else if (nodes[nodes[high].parent].child1 == a) {
+      nodes[nodes[high].parent].child1 = high;
+    } else {
+      nodes[nodes[high].parent].child2 = high;
+    }
+
+    // A KEEPS THE SHORTER GRANDCHILD, HIGH KEEPS THE TALLER ONE
+    int32_t keep = nodes[f].height > nodes[g].height ? f : g;
+    int32_t give = keep == f ? g : f;
+
+    nodes[high].child2 = keep;
+    if (rotateRight)
+      nodes[a].child2 = give;
+    else
+      nodes[a].child1 = give;
+    nodes[give].parent = a;
+
+    nodes[a].box = AABB::merge(nodes[low].box, nodes[give].box);
+    nodes[high].box = AABB::merge(nodes[a].box, nodes[keep].box);
+
+    nodes[a].height = 1 + std::max(nodes[low].height, nodes[give].height);
+    nodes[high].height = 1 + std::max(nodes[a].height, nodes[keep].height);
+
+    return high;
+  }
+
+  return a;
+}
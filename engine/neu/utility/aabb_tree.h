@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "components/component_type.h"
+#include "utility/bounds.h"
+
+namespace Neu {
+
+// HOW FAR LEAF BOXES ARE FATTENED, SO SMALL MOVES DO NOT REINSERT THE LEAF
+#define AABB_TREE_MARGIN 0.1f
+
+// TRAVERSAL STACK DEPTH, THE TREE IS KEPT BALANCED SO THIS IS NEVER REACHED
+#define AABB_TREE_STACK_SIZE 256
+
+/**
+ * Dynamic bounding volume hierarchy over entities. Every proxy is a leaf
+ * holding a slightly enlarged ("fat") box; internal nodes hold the union of
+ * their children. Leaves are inserted next to the sibling that grows the
+ * tree's surface area the least and the tree is rebalanced with rotations on
+ * the way up, so queries visit O(log n) nodes.
+ *
+ * Queries test the fat boxes, so callers that need an exact answer must test
+ * the entity's own bounds in the callback.
+ */
+class DynamicAABBTree {
+ public:
+  static constexpr int32_t NULL_NODE = -1;
+
+  /**
+   * Inserts a leaf for the entity and returns its proxy ID.
+   */
+  int32_t createProxy(const AABB& box, Entity entity);
+  void destroyProxy(int32_t proxy);
+
+  /**
+   * Updates the box of a proxy. The leaf is only reinserted if the new box
+   * left its fat box; returns true if it was.
+   */
+  bool moveProxy(int32_t proxy, const AABB& box);
+
+  Entity getEntity(int32_t proxy) const { return nodes[proxy].entity; }
+  const AABB& getFatBox(int32_t proxy) const { return nodes[proxy].box; }
+
+  size_t getProxyCount() const { return proxyCount; }
+  int32_t getHeight() const {
+    return root == NULL_NODE ? 0 : nodes[root].height;
+  }
+
+  /////////////
+  // QUERIES //
+  /////////////
+
+  // EVERY QUERY CALLS func(entity) FOR THE PROXIES WHOSE FAT BOX MATCHES;
+  // func RETURNS FALSE TO STOP THE QUERY
+
+  template <typename Func>
+  void query(const AABB& box, Func&& func) const {
+    traverse([&box](const AABB& nodeBox) { return nodeBox.overlaps(box); },
+             func);
+  }
+
+  template <typename Func>
+  void query(const Frustum& frustum, Func&& func) const {
+    traverse([&frustum](const AABB& nodeBox) {
+      return frustum.intersects(nodeBox);
+    }, func);
+  }
+
+  template <typename Func>
+  void querySphere(const Vector3f& center, float radius, Func&& func) const {
+    traverse([&center, radius](const AABB& nodeBox) {
+      return nodeBox.intersectsSphere(center, radius);
+    }, func);
+  }
+
+  /**
+   * Walks the proxies whose fat box is hit by the ray origin + t * direction,
+   * t in [0, maxDistance], calling func(entity, maxDistance). func returns the
+   * new maximum distance: the exact hit distance to clip the ray (used to
+   * find the closest hit), maxDistance to ignore the proxy, or 0 to stop.
+   */
+  template <typename Func>
+  void raycast(const Vector3f& origin, const Vector3f& direction,
+               float maxDistance, Func&& func) const {
+    if (root == NULL_NODE) return;
+
+    const Vector3f inverseDirection(1.0f / direction.x, 1.0f / direction.y,
+                                    1.0f / direction.z);
+
+    int32_t stack[AABB_TREE_STACK_SIZE];
+    int32_t stackSize = 0;
+    stack[stackSize++] = root;
+
+    while (stackSize > 0) {
+      const Node& node = nodes[stack[--stackSize]];
+
+      float distance;
+      if (!node.box.intersectsRay(origin, inverseDirection, maxDistance,
+                                  distance))
+        continue;
+
+      if (node.isLeaf()) {
+        maxDistance = func(node.entity, maxDistance);
+        if (maxDistance <= 0.0f) return;
+        continue;
+      }
+
+      assert(stackSize + 2 <= AABB_TREE_STACK_SIZE);
+      stack[stackSize++] = node.child1;
+      stack[stackSize++] = node.child2;
+    }
+  }
+
+ private:
+  struct Node {
+    AABB box;
+    Entity entity = NULL_ENTITY;
+
+    // NEXT FREE NODE WHILE THE NODE IS ON THE FREE LIST
+    int32_t parent = NULL_NODE;
+    int32_t child1 = NULL_NODE;
+    int32_t child2 = NULL_NODE;
+
+    // LEAVES ARE 0, FREE NODES ARE -1
+    int32_t height = -1;
+
+    bool isLeaf() const { return child1 == NULL_NODE; }
+  };
+
+  /**
+   * Calls func(entity) for every proxy whose fat box passes the test. The
+   * test is called with each node box; func returns false to stop.
+   */
+  template <typename Test, typename Func>
+  void traverse(Test&& test, Func&& func) const {
+    if (root == NULL_NODE) return;
+
+    int32_t stack[AABB_TREE_STACK_SIZE];
+    int32_t stackSize = 0;
+    stack[stackSize++] = root;
+
+    while (stackSize > 0) {
+      const Node& node = nodes[stack[--stackSize]];
+      if (!test(node.box)) continue;
+
+      if (node.isLeaf()) {
+        if (!func(node.entity)) return;
+        continue;
+      }
+
+      assert(stackSize + 2 <= AABB_TREE_STACK_SIZE);
+      stack[stackSize++] = node.child1;
+      stack[stackSize++] = node.child2;
+    }
+  }
+
+  int32_t allocateNode();
+  void freeNode(int32_t node);
+
+  void insertLeaf(int32_t leaf);
+  void removeLeaf(int32_t leaf);
+
+  /**
+   * Rotates the subtree at node if its children differ in height by more
+   * than one and returns the new subtree root.
+   */
+  int32_t balance(int32_t node);
+
+  std::vector<Node> nodes;
+  int32_t root = NULL_NODE;
+  int32_t freeList = NULL_NODE;
+  size_t proxyCount = 0;
+};
+
+}  // namespace Neu
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+
+#include "math/Matrix.h"
+#include "math/Vector.h"
+
+namespace Neu {
+
+/**
+ * Axis-aligned bounding box.
+ */
+struct AABB {
+  Vector3f min{std::numeric_limits<float>::max(),
+               std::numeric_limits<float>::max(),
+               std::numeric_limits<float>::max()};
+  Vector3f max{std::numeric_limits<float>::lowest(),
+               std::numeric_limits<float>::lowest(),
+               std::numeric_limits<float>::lowest()};
+
+  bool isValid() const { return min.x <= max.x; }
+
+  void expand(const Vector3f& point) {
+    min = Vector3f(std::fmin(min.x, point.x), std::fmin(min.y, point.y),
+                   std::fmin(min.z, point.z));
+    max = Vector3f(std::fmax(max.x, point.x), std::fmax(max.y, point.y),
+                   std::fmax(max.z, point.z));
+  }
+
+  Vector3f getCenter() const { return (min + max) * 0.5f; }
+
+  float getSurfaceArea() const {
+    Vector3f size = max - min;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+  }
+
+  bool contains(const AABB& box) const {
+    return min.x <= box.min.x && min.y <= box.min.y && min.z <= box.min.z &&
+           box.max.x <= max.x && box.max.y <= max.y && box.max.z <= max.z;
+  }
+
+  bool overlaps(const AABB& box) const {
+    return min.x <= box.max.x && box.min.x <= max.x && min.y <= box.max.y &&
+           box.min.y <= max.y && min.z <= box.max.z && box.min.z <= max.z;
+  }
+
+  bool intersectsSphere(const Vector3f& center, float radius) const {
+    float distanceSquared = 0.0f;
+
+    for (int axis = 0; axis < 3; axis++) {
+      float closest = std::fmin(std::fmax(center[axis], min[axis]), max[axis]);
+      float offset = center[axis] - closest;
+      distanceSquared += offset * offset;
+    }
+
+    return distanceSquared <= radius * radius;
+  }
+
+  /**
+   * Slab test against the ray origin + t * direction, t in [0, maxDistance].
+   * Takes the reciprocal of the direction so it can be computed once per ray.
+   * On a hit, distance is set to the entry point (0 if the origin is inside).
+   */
+  bool intersectsRay(const Vector3f& origin, const Vector3f& inverseDirection,
+                     float maxDistance, float& distance) const {
+    float entryDistance = 0.0f;
+    float exitDistance = maxDistance;
+
+    for (int axis = 0; axis < 3; axis++) {
+      float t1 = (min[axis] - origin[axis]) * inverseDirection[axis];
+      float t2 = (max[axis] - origin[axis]) * inverseDirection[axis];
+
+      // fmin/fmax DROP THE NaN OF A 0 * INF AXIS THE RAY IS PARALLEL TO
+      entryDistance = std::fmax(entryDistance, std::fmin(t1, t2));
+      exitDistance = std::fmin(exitDistance, std::fmax(t1, t2));
+    }
+
+    if (entryDistance > exitDistance) return false;
+
+    distance = entryDistance;
+    return true;
+  }
+
+  static AABB merge(const AABB& a, const AABB& b) {
+    AABB result;
+    result.min = Vector3f(std::fmin(a.min.x, b.min.x),
+                          std::fmin(a.min.y, b.min.y),
+                          std::fmin(a.min.z, b.min.z));
+    result.max = Vector3f(std::fmax(a.max.x, b.max.x),
+                          std::fmax(a.max.y, b.max.y),
+                          std::fmax(a.max.z, b.max.z));
+    return result;
+  }
+
+  /**
+   * Returns the box that encloses this box after transformation by matrix
+   * (center/extent form, so no corners need to be transformed).
+   */
+  AABB transformed(const Matrix4x4f& matrix) const {
+    Vector3f center = (min + max) * 0.5f;
+    Vector3f extent = (max - min) * 0.5f;
+
+    float newCenter[3];
+    float newExtent[3];
+
+    for (int row = 0; row < 3; row++) {
+      newCenter[row] = matrix(row, 0) * center.x + matrix(row, 1) * center.y +
+                       matrix(row, 2) * center.z + matrix(row, 3);
+      newExtent[row] = std::fabs(matrix(row, 0)) * extent.x +
+                       std::fabs(matrix(row, 1)) * extent.y +
+                       std::fabs(matrix(row, 2)) * extent.z;
+    }
+
+    AABB result;
+    result.min = Vector3f(newCenter[0] - newExtent[0],
+                          newCenter[1] - newExtent[1],
+                          newCenter[2] - newExtent[2]);
+    result.max = Vector3f(newCenter[0] + newExtent[0],
+                          newCenter[1] + newExtent[1],
+                          newCenter[2] + newExtent[2]);
+    return result;
+  }
+};
+
+/**
+ * The six planes of a view frustum, pointing inwards. Each plane is stored
+ * as (a, b, c, d) with a * x + b * y + c * z + d >= 0 for points inside.
+ */
+struct Frustum {
+  enum Planes {
+    LEFT_PLANE,
+    RIGHT_PLANE,
+    BOTTOM_PLANE,
+    TOP_PLANE,
+    NEAR_PLANE,
+    FAR_PLANE,
+    PLANE_COUNT  // KEEP AS LAST ITEM
+  };
+
+  Vector4f planes[PLANE_COUNT];
+
+  /**
+   * Extracts the planes from a (projection * view) matrix (Gribb/Hartmann).
+   */
+  static Frustum fromMatrix(const Matrix4x4f& viewProjection) {
+    auto row = [&](int i) {
+      return Vector4f(viewProjection(i, 0), viewProjection(i, 1),
+                      viewProjection(i, 2), viewProjection(i, 3));
+    };
+
+    Frustum frustum;
+    frustum.planes[LEFT_PLANE] = row(3) + row(0);
+    frustum.planes[RIGHT_PLANE] = row(3) - row(0);
+    frustum.planes[BOTTOM_PLANE] = row(3) + row(1);
+    frustum.planes[TOP_PLANE] = row(3) - row(1);
+    frustum.planes[NEAR_PLANE] = row(3) + row(2);
+    frustum.planes[FAR_PLANE] = row(3) - row(2);
+
+    return frustum;
+  }
+
+  /**
+   * Conservative box test: false only if the box lies entirely outside one of
+   * the planes.
+   */
+  bool intersects(const AABB& box) const {
+    for (const Vector4f& plane : planes) {
+      // CORNER FURTHEST ALONG THE PLANE NORMAL
+      float x = plane.x >= 0.0f ? box.max.x : box.min.x;
+      float y = plane.y >= 0.0f ? box.max.y : box.min.y;
+      float z = plane.z >= 0.0f ? box.max.z : box.min.z;
+
+      if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f)
+        return false;
+    }
+
+    return true;
+  }
+};
+
+}  // namespace Neu
@@ -0,0 +1,118 @@
+#include "profiler.h"
+
+#include "core.h"
+
+using namespace Neu;
+
+//////////////////
+// GPU PROFILER //
+//////////////////
+
+GPUProfiler::GPUProfiler() : ownerThread(std::this_thread::get_id()) {}
+
+void GPUProfiler::beginFrame() {
+  if (std::this_thread::get_id() != ownerThread) return;
+
+  const int nextFrame = (currentFrame + 1) % GPU_PROFILER_FRAME_LATENCY;
+  Frame& frame = frames[nextFrame];
+
+  if (frame.usedQueries > 0) {
+    // QUERIES COMPLETE IN ORDER, SO THE LAST ONE DECIDES
+    GLint available = 0;
+    glGetQueryObjectiv(frame.queries[frame.usedQueries - 1],
+                       GL_QUERY_RESULT_AVAILABLE, &available);
+
+    // DO NOT STALL, TRY THE SAME POOL AGAIN NEXT FRAME
+    if (!available) {
+      measuring = false;
+      return;
+    }
+
+    results.clear();
+
+    for (const Section& section : frame.sections) {
+      GLuint64 startTime = 0;
+      GLuint64 stopTime = 0;
+      glGetQueryObjectui64v(frame.queries[section.startQuery], GL_QUERY_RESULT,
+                            &startTime);
+      glGetQueryObjectui64v(frame.queries[section.stopQuery], GL_QUERY_RESULT,
+                            &stopTime);
+
+      results.push_back(
+          {section.name, section.depth, (stopTime - startTime) / 1000000.0});
+    }
+  }
+
+  frame.usedQueries = 0;
+  frame.sections.clear();
+
+  currentFrame = nextFrame;
+  measuring = true;
+  depth = 0;
+}
+
+int GPUProfiler::start(const char* sectionName) {
+  if (!measuring || std::this_thread::get_id() != ownerThread) return -1;
+
+  Frame& frame = frames[currentFrame];
+
+  Section section;
+  section.name = sectionName;
+  section.depth = depth++;
+  section.startQuery = allocateQuery(frame);
+
+  // UNTIL STOPPED, SO AN OPEN SECTION READS AS ZERO
+  section.stopQuery = section.startQuery;
+
+  glQueryCounter(frame.queries[section.startQuery], GL_TIMESTAMP);
+
+  frame.sections.push_back(section);
+
+  return static_cast<int>(frame.sections.size() - 1);
+}
+
+void GPUProfiler::stop(int sectionID) {
+  if (sectionID < 0 || !measuring) return;
+
+  Frame& frame = frames[currentFrame];
+  Section& section = frame.sections[sectionID];
+
+  // ALLOCATED NOW, SO POOL ORDER MATCHES THE ORDER THE QUERIES ARE ISSUED IN
+  section.stopQuery = allocateQuery(frame);
+
+  glQueryCounter(frame.queries[section.stopQuery], GL_TIMESTAMP);
+
+  depth--;
+}
+
+size_t GPUProfiler::allocateQuery(Frame& frame) {
+  if (frame.usedQueries == frame.queries.size()) {
+    unsigned int query;
+    glGenQueries(1, &query);
+    frame.queries.push_back(query);
+  }
+
+  return frame.usedQueries++;
+}
+
+void GPUProfiler::shutdown() {
+  for (Frame& frame : frames) {
+    if (!frame.queries.empty())
+      glDeleteQueries(static_cast<GLsizei>(frame.queries.size()),
+                      frame.queries.data());
+
+    frame.queries.clear();
+    frame.usedQueries = 0;
+    frame.sections.clear();
+  }
+
+  measuring = false;
+}
+
+GPUProfilerAgent::GPUProfilerAgent(const char* sectionName) {
+  sectionID = GPUProfiler::getInstance().start(sectionName);
+}
+
+GPUProfilerAgent::~GPUProfilerAgent() {
+  GPUProfiler::getInstance().stop(sectionID);
+}
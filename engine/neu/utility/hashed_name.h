@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace Neu {
+
+/**
+ * 32-bit FNV-1a hash of a name, used to look up shaders, uniforms and uniform
+ * blocks without string comparisons. Constructing one from a string literal
+ * is forced to happen at compile time; names only known at runtime go
+ * through fromString.
+ */
+struct HashedName {
+  uint32_t hash = 0;
+
+  constexpr HashedName() = default;
+
+  consteval HashedName(const char* name) : hash(compute(name)) {}
+
+  static constexpr HashedName fromString(std::string_view name) {
+    HashedName hashedName;
+    hashedName.hash = compute(name);
+    return hashedName;
+  }
+
+  static constexpr uint32_t compute(std::string_view name) {
+    uint32_t result = 2166136261u;
+
+    for (char character : name) {
+      result ^= static_cast<uint8_t>(character);
+      result *= 16777619u;
+    }
+
+    return result;
+  }
+
+  constexpr bool operator==(const HashedName& other) const {
+    return hash == other.hash;
+  }
+};
+
+}  // namespace Neu
@@ -0,0 +1,65 @@
+#include "job_system.h"
+
+#include <chrono>
+#include <thread>
+
+#include "utility/logger.h"
+#include "utility/thread_pool.h"
+
+using namespace Neu;
+
+JobSystem::JobSystem(ThreadPool* threadPool, JPH::uint maxJobs,
+                     JPH::uint maxBarriers)
+    : threadPool(threadPool) {
+  JobSystemWithBarrier::Init(maxBarriers);
+  jobs.Init(maxJobs, maxJobs);
+}
+
+int JobSystem::GetMaxConcurrency() const {
+  // THE THREAD WAITING ON A BARRIER ALSO EXECUTES JOBS
+  return static_cast<int>(threadPool->getWorkerCount()) + 1;
+}
+
+JPH::JobSystem::JobHandle JobSystem::CreateJob(const char* name,
+                                               JPH::ColorArg color,
+                                               const JobFunction& jobFunction,
+                                               JPH::uint32 numDependencies) {
+  JPH::uint32 index;
+  bool warned = false;
+
+  // WAIT FOR A FREE JOB IF THE LIST IS EXHAUSTED
+  while ((index = jobs.ConstructObject(name, color, this, jobFunction,
+                                       numDependencies)) ==
+         JPH::FixedSizeFreeList<Job>::cInvalidObjectIndex) {
+    if (!warned) Logger::warn("Job system ran out of jobs, waiting\n");
+    warned = true;
+
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+
+  Job* job = &jobs.Get(index);
+
+  // THE HANDLE KEEPS THE JOB ALIVE, IT MAY COMPLETE AS SOON AS IT IS QUEUED
+  JobHandle handle(job);
+
+  if (numDependencies == 0) QueueJob(job);
+
+  return handle;
+}
+
+void JobSystem::QueueJob(Job* job) {
+  // THE POOL TASK HOLDS A REFERENCE UNTIL THE JOB HAS RUN
+  job->AddRef();
+
+  threadPool->submit([job]() {
+    // NO-OP IF A THREAD WAITING ON A BARRIER ALREADY RAN THE JOB
+    job->Execute();
+    job->Release();
+  });
+}
+
+void JobSystem::QueueJobs(Job** jobs, JPH::uint numJobs) {
+  for (JPH::uint i = 0; i < numJobs; i++) QueueJob(jobs[i]);
+}
+
+void JobSystem::FreeJob(Job* job) { jobs.DestructObject(job); }
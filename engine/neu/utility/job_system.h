@@ -0,0 +1,44 @@
+#pragma once
+
+// clang-format off
+#include <Jolt/Jolt.h>
+
+#include <Jolt/Core/FixedSizeFreeList.h>
+#include <Jolt/Core/JobSystemWithBarrier.h>
+// clang-format on
+
+namespace Neu {
+
+class ThreadPool;
+
+/**
+ * Implementation of Jolt's job system on top of the engine's thread pool, so
+ * physics jobs share the same workers (and queues) as every other system.
+ * Jobs are allocated from a fixed-size free list; a job is pushed to the pool
+ * once all of its dependencies have finished.
+ */
+class JobSystem final : public JPH::JobSystemWithBarrier {
+ public:
+  JobSystem(ThreadPool* threadPool, JPH::uint maxJobs, JPH::uint maxBarriers);
+
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+
+  int GetMaxConcurrency() const override;
+
+  JobHandle CreateJob(const char* name, JPH::ColorArg color,
+                      const JobFunction& jobFunction,
+                      JPH::uint32 numDependencies = 0) override;
+
+ protected:
+  void QueueJob(Job* job) override;
+  void QueueJobs(Job** jobs, JPH::uint numJobs) override;
+  void FreeJob(Job* job) override;
+
+ private:
+  ThreadPool* threadPool;
+
+  JPH::FixedSizeFreeList<Job> jobs;
+};
+
+}  // namespace Neu
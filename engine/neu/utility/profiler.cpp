@@ -1,85 +1,115 @@
-#include "Profiler.h"
+#include "profiler.h"
 
-#include <cassert>
 #include <queue>
 
-#include "core.h"
+#include "utility/logger.h"
 
 using namespace Neu;
 
-Profiler::Profiler() {}
+// TREE OF THE CALLING THREAD
+static thread_local ProfilerThread *currentThread = nullptr;
+
+/////////////////////
+// PROFILER THREAD //
+/////////////////////
+
+std::chrono::duration<double> ProfilerThread::getTimeForSection(
+    unsigned int sectionID) const {
+  if (sectionID >= endTimes.size()) return std::chrono::duration<double>(0);
+
+  return endTimes[sectionID];
+}
+
+void ProfilerThread::clear() {
+  lastSection = -1;
+
+  startTimes.clear();
+  endTimes.clear();
+
+  ///////////////////////////////
+  // FREE PROFILER TREE MEMORY //
+  ///////////////////////////////
+
+  for (ProfilerSection *section : profilerData) delete section;
+
+  profilerData.clear();
+}
+
+//////////////
+// PROFILER //
+//////////////
 
 int Profiler::start(std::string sectionName) {
-  if (intervalCount == 0) {
-    ProfilerSection *childSection = new ProfilerSection();
-    childSection->ID = currentID;
-    childSection->name = sectionName;
-    childSection->parentSection = lastSection;
+  if (intervalCount != 0) return -1;
 
-    profilerData.push_back(childSection);
+  ProfilerThread &thread = getThread();
 
-    // PUSH ONLY IF ROOT
-    if (currentID > 0) profilerData[lastSection]->children.push_back(currentID);
+  ProfilerSection *childSection = new ProfilerSection();
+  childSection->ID = static_cast<int>(thread.profilerData.size());
+  childSection->name = sectionName;
+  childSection->parentSection = thread.lastSection;
 
-    startTimes.push_back(std::chrono::high_resolution_clock::now());
+  thread.profilerData.push_back(childSection);
 
-    lastSection = currentID;
+  // ROOTS HAVE NO PARENT TO BE LISTED IN
+  if (thread.lastSection >= 0)
+    thread.profilerData[thread.lastSection]->children.push_back(
+        childSection->ID);
 
-    // CHECK CURRENT SECTION IS LAST SECTION
-    assert(currentID == profilerData.size() - 1);
+  thread.startTimes.push_back(std::chrono::high_resolution_clock::now());
 
-    currentID++;
+  thread.lastSection = childSection->ID;
 
-    return childSection->ID;
-  }
+  return childSection->ID;
 }
 
 void Profiler::stop(int sectionID) {
-  if (intervalCount == 0) {
-    if (sectionID != lastSection) {
-      Logger::warn(
-          "Mismatched stop category name with last section profiled\n");
-      Logger::warn("\tCurrent function: %s\n",
-                   profilerData[sectionID]->name.c_str());
-      Logger::warn("\tLast function: %s\n",
-                   profilerData[lastSection]->name.c_str());
-    }
-
-    if (endTimes.size() < startTimes.size()) endTimes.resize(startTimes.size());
-
-    endTimes[sectionID] =
-        std::chrono::high_resolution_clock::now() - startTimes[sectionID];
-
-    lastSection = profilerData[sectionID]->parentSection;
+  // NOT RECORDED
+  if (sectionID < 0) return;
+
+  ProfilerThread &thread = getThread();
+
+  if (sectionID != thread.lastSection) {
+    Logger::warn("Mismatched stop category name with last section profiled\n");
+    Logger::warn("\tCurrent function: %s\n",
+                 thread.profilerData[sectionID]->name.c_str());
+    Logger::warn("\tLast function: %s\n",
+                 thread.lastSection >= 0
+                     ? thread.profilerData[thread.lastSection]->name.c_str()
+                     : "none");
   }
-}
 
-std::chrono::duration<double> Profiler::getTimeForSection(
-    unsigned int sectionID) {
-  if (sectionID >= endTimes.size()) return std::chrono::duration<double>(0);
+  if (thread.endTimes.size() < thread.startTimes.size())
+    thread.endTimes.resize(thread.startTimes.size());
 
-  return endTimes[sectionID];
+  thread.endTimes[sectionID] = std::chrono::high_resolution_clock::now() -
+                               thread.startTimes[sectionID];
+
+  thread.lastSection = thread.profilerData[sectionID]->parentSection;
 }
 
 void Profiler::reset() {
   intervalCount++;
 
   if (intervalCount >= sampleInterval) {
-    lastSection = 0;
-    currentID = 0;
     intervalCount = 0;
 
-    startTimes.clear();
-    endTimes.clear();
+    std::lock_guard<std::mutex> lock(threadsMutex);
 
-    ///////////////////////////////
-    // FREE PROFILER TREE MEMORY //
-    ///////////////////////////////
+    for (std::unique_ptr<ProfilerThread> &thread : threads) thread->clear();
+  }
+}
 
-    for (ProfilerSection *section : profilerData) free(section);
+ProfilerThread &Profiler::getThread() {
+  if (currentThread) return *currentThread;
 
-    profilerData.clear();
-  }
+  std::lock_guard<std::mutex> lock(threadsMutex);
+
+  threads.push_back(std::make_unique<ProfilerThread>());
+  currentThread = threads.back().get();
+  currentThread->name = "Worker " + std::to_string(threads.size() - 1);
+
+  return *currentThread;
 }
 
 ////////////////////
@@ -90,4 +120,4 @@ ProfilerAgent::ProfilerAgent(std::string sectionName) {
   sectionID = Profiler::getInstance().start(sectionName);
 }
 
-ProfilerAgent::~ProfilerAgent() { Profiler::getInstance().stop(sectionID); }
\ No newline at end of file
+ProfilerAgent::~ProfilerAgent() { Profiler::getInstance().stop(sectionID); }
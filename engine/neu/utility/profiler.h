@@ -1,7 +1,11 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #define NEU_PROFILE_FUNCTION Neu::ProfilerAgent neuProfilerAgent(__FUNCTION__)
@@ -17,13 +21,21 @@
 #define NEU_PROFILE_STOP_CUSTOM(NAME) \
   Neu::Profiler::getInstance().stop(neuProfilerSectionID_##NAME)
 
+// MEASURES THE GPU TIME OF THE GL COMMANDS ISSUED UNTIL THE END OF THE SCOPE
+#define NEU_PROFILE_GPU(NAME) \
+  Neu::GPUProfilerAgent neuGPUProfilerAgent_##NAME(#NAME)
+
+// FRAMES OF TIMER QUERIES IN FLIGHT, A FRAME IS READ BACK THIS MANY FRAMES
+// AFTER IT WAS MEASURED
+#define GPU_PROFILER_FRAME_LATENCY 4
+
 namespace Neu {
 
 struct ProfilerSection {
   int ID;
   std::string name;
   std::vector<int> children;
-  int parentSection;
+  int parentSection;  // -1 FOR ROOTS
 };
 
 struct ProfilerTreeNode {
@@ -33,6 +45,39 @@ struct ProfilerTreeNode {
   std::vector<ProfilerTreeNode> children;
 };
 
+/**
+ * Sections recorded by one thread. A section started while another one is
+ * open on the same thread becomes its child, any other section is a root
+ * (e.g. every task a thread pool worker runs).
+ */
+struct ProfilerThread {
+  ~ProfilerThread() { clear(); }
+
+  std::chrono::duration<double> getTimeForSection(
+      unsigned int sectionID) const;
+
+  void clear();
+
+  std::string name;
+
+  std::vector<ProfilerSection*> profilerData;
+  int lastSection = -1;
+
+  std::vector<std::chrono::time_point<std::chrono::high_resolution_clock>>
+      startTimes;
+  std::vector<std::chrono::duration<double>> endTimes;
+};
+
+/**
+ * Section profiler. Every thread that starts a section records into its own
+ * tree, so systems and jobs running on thread pool workers are measured as
+ * well as the main thread.
+ *
+ * Sections are recorded one frame out of every sampleInterval. reset() is
+ * called by the main thread between frames, and the trees may only be read
+ * there too, while no other thread is inside a section. Threads are listed
+ * under the name given to setThreadName, or as "Worker N".
+ */
 class Profiler {
  public:
   static Profiler& getInstance() {
@@ -40,29 +85,125 @@ class Profiler {
     return instance;
   }
 
-  Profiler();
-
   int start(std::string sectionName);
   void stop(int sectionID);
-  std::chrono::duration<double> getTimeForSection(unsigned int sectionID);
 
   void reset();
 
-  std::vector<ProfilerSection*>& getProfilerData() { return profilerData; }
-  std::vector<std::chrono::duration<double>>& getEndTimes() { return endTimes; }
+  // NAMES THE TREE OF THE CALLING THREAD, REGISTERING IT IF IT HAS NONE YET
+  void setThreadName(const std::string& name) { getThread().name = name; }
+
+  // TRUE WHILE THE CURRENT FRAME IS RECORDED
+  bool isRecording() const { return intervalCount == 0; }
+
+  // IN THE ORDER THE THREADS WERE REGISTERED (THE APPLICATION REGISTERS THE
+  // MAIN THREAD FIRST)
+  const std::vector<std::unique_ptr<ProfilerThread>>& getThreads() const {
+    return threads;
+  }
+
+  // FRACTION OF TIME EACH THREAD POOL WORKER WAS BUSY
+  void setWorkerUtilization(const std::vector<float>& utilization) {
+    workerUtilization = utilization;
+  }
+  const std::vector<float>& getWorkerUtilization() const {
+    return workerUtilization;
+  }
 
  private:
-  std::vector<ProfilerSection*> profilerData;
-  int lastSection = 0;
+  // TREE OF THE CALLING THREAD, CREATED ON ITS FIRST SECTION
+  ProfilerThread& getThread();
 
-  std::vector<std::chrono::time_point<std::chrono::high_resolution_clock>>
-      startTimes;
-  std::vector<std::chrono::duration<double>> endTimes;
+  std::vector<std::unique_ptr<ProfilerThread>> threads;
+  std::mutex threadsMutex;
 
   const int sampleInterval = 15;
-  int intervalCount = 0;
+  // WRITTEN BY reset(), READ BY EVERY THREAD THAT STARTS A SECTION
+  std::atomic<int> intervalCount{0};
+
+  std::vector<float> workerUtilization;
+};
 
-  int currentID = 0;
+struct GPUProfilerSection {
+  const char* name;
+  int depth;
+  double milliseconds;
+};
+
+/**
+ * GPU counterpart of Profiler, built on GL_TIMESTAMP queries (which, unlike
+ * GL_TIME_ELAPSED, can be nested). Each frame issues its queries from its own
+ * pool, one of GPU_PROFILER_FRAME_LATENCY, and is only read back when its
+ * pool comes around again. If the GPU has not finished it by then, the new
+ * frame is not measured instead of waiting for the results.
+ *
+ * Only sections on the thread that owns the GL context are measured. It is
+ * defined in gpu_profiler.cpp, so tools that only use Profiler do not have
+ * to link a GL loader.
+ */
+class GPUProfiler {
+ public:
+  static GPUProfiler& getInstance() {
+    static GPUProfiler instance;
+    return instance;
+  }
+
+  GPUProfiler();
+
+  /**
+   * Reads back the oldest frame and starts measuring the next one. Called
+   * once per frame, before any section.
+   */
+  void beginFrame();
+
+  int start(const char* sectionName);
+  void stop(int sectionID);
+
+  // DELETES THE QUERY OBJECTS, MUST RUN WHILE THE CONTEXT EXISTS
+  void shutdown();
+
+  // SECTIONS OF THE LAST FRAME READ BACK, IN START ORDER
+  const std::vector<GPUProfilerSection>& getResults() const { return results; }
+
+ private:
+  struct Section {
+    const char* name;
+    int depth;
+
+    // INDICES INTO THE QUERY POOL OF THE FRAME
+    size_t startQuery;
+    size_t stopQuery;
+  };
+
+  struct Frame {
+    // GROWS TO THE MOST QUERIES A FRAME HAS USED
+    std::vector<unsigned int> queries;
+    size_t usedQueries = 0;
+
+    std::vector<Section> sections;
+  };
+
+  size_t allocateQuery(Frame& frame);
+
+  Frame frames[GPU_PROFILER_FRAME_LATENCY];
+  int currentFrame = 0;
+
+  // FALSE WHILE THE NEXT POOL IS STILL IN FLIGHT
+  bool measuring = false;
+  int depth = 0;
+
+  std::vector<GPUProfilerSection> results;
+
+  std::thread::id ownerThread;
+};
+
+class GPUProfilerAgent {
+ public:
+  GPUProfilerAgent(const char* sectionName);
+  ~GPUProfilerAgent();
+
+ private:
+  int sectionID;
 };
 
 class ProfilerAgent  // lol
@@ -72,7 +213,7 @@ class ProfilerAgent  // lol
   ~ProfilerAgent();
 
  private:
-  unsigned int sectionID;
+  int sectionID;
 };
 
 };  // namespace Neu
\ No newline at end of file
@@ -0,0 +1,178 @@
+#pragma once
+
+/*
+ * Thin wrappers over the SSE2 and AVX2 intrinsics so batched math can be
+ * written once as a template and instantiated for 4 or 8 lanes. The widest
+ * instruction set enabled at compile time is exposed as SimdBest (compile
+ * with -mavx2 -mfma, or /arch:AVX2, to get 8 lanes).
+ */
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NEU_SIMD_AVX2
+#define NEU_SIMD_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NEU_SIMD_SSE2
+#endif
+
+namespace Neu {
+
+#ifdef NEU_SIMD_SSE2
+
+struct SimdSSE2 {
+  using Float = __m128;
+  using Int = __m128i;
+
+  static constexpr int width = 4;
+
+  static Float load(const float* p) { return _mm_load_ps(p); }
+  static void store(float* p, Float a) { _mm_store_ps(p, a); }
+  static Float set1(float x) { return _mm_set1_ps(x); }
+
+  static Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+  static Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+  static Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+  static Float bitAnd(Float a, Float b) { return _mm_and_ps(a, b); }
+  static Float bitAndNot(Float a, Float b) { return _mm_andnot_ps(a, b); }
+  static Float bitOr(Float a, Float b) { return _mm_or_ps(a, b); }
+  static Float bitXor(Float a, Float b) { return _mm_xor_ps(a, b); }
+  static Float max(Float a, Float b) { return _mm_max_ps(a, b); }
+
+  // ALL BITS OF A LANE SET WHERE a <= b, ONE BIT PER LANE FOR moveMask
+  static Float lessEqual(Float a, Float b) { return _mm_cmple_ps(a, b); }
+  static int moveMask(Float a) { return _mm_movemask_ps(a); }
+
+  static Int truncate(Float a) { return _mm_cvttps_epi32(a); }
+  static Float toFloat(Int a) { return _mm_cvtepi32_ps(a); }
+  static Float asFloat(Int a) { return _mm_castsi128_ps(a); }
+
+  static Int set1(int x) { return _mm_set1_epi32(x); }
+  static Int add(Int a, Int b) { return _mm_add_epi32(a, b); }
+  static Int sub(Int a, Int b) { return _mm_sub_epi32(a, b); }
+  static Int bitAnd(Int a, Int b) { return _mm_and_si128(a, b); }
+  static Int bitAndNot(Int a, Int b) { return _mm_andnot_si128(a, b); }
+  static Int equal(Int a, Int b) { return _mm_cmpeq_epi32(a, b); }
+  static Int shiftLeft29(Int a) { return _mm_slli_epi32(a, 29); }
+};
+
+#endif
+
+#ifdef NEU_SIMD_AVX2
+
+struct SimdAVX2 {
+  using Float = __m256;
+  using Int = __m256i;
+
+  static constexpr int width = 8;
+
+  static Float load(const float* p) { return _mm256_load_ps(p); }
+  static void store(float* p, Float a) { _mm256_store_ps(p, a); }
+  static Float set1(float x) { return _mm256_set1_ps(x); }
+
+  static Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+  static Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+  static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+  static Float bitAnd(Float a, Float b) { return _mm256_and_ps(a, b); }
+  static Float bitAndNot(Float a, Float b) { return _mm256_andnot_ps(a, b); }
+  static Float bitOr(Float a, Float b) { return _mm256_or_ps(a, b); }
+  static Float bitXor(Float a, Float b) { return _mm256_xor_ps(a, b); }
+  static Float max(Float a, Float b) { return _mm256_max_ps(a, b); }
+
+  static Float lessEqual(Float a, Float b) {
+    return _mm256_cmp_ps(a, b, _CMP_LE_OQ);
+  }
+  static int moveMask(Float a) { return _mm256_movemask_ps(a); }
+
+  static Int truncate(Float a) { return _mm256_cvttps_epi32(a); }
+  static Float toFloat(Int a) { return _mm256_cvtepi32_ps(a); }
+  static Float asFloat(Int a) { return _mm256_castsi256_ps(a); }
+
+  static Int set1(int x) { return _mm256_set1_epi32(x); }
+  static Int add(Int a, Int b) { return _mm256_add_epi32(a, b); }
+  static Int sub(Int a, Int b) { return _mm256_sub_epi32(a, b); }
+  static Int bitAnd(Int a, Int b) { return _mm256_and_si256(a, b); }
+  static Int bitAndNot(Int a, Int b) { return _mm256_andnot_si256(a, b); }
+  static Int equal(Int a, Int b) { return _mm256_cmpeq_epi32(a, b); }
+  static Int shiftLeft29(Int a) { return _mm256_slli_epi32(a, 29); }
+};
+
+using SimdBest = SimdAVX2;
+
+#elif defined(NEU_SIMD_SSE2)
+
+using SimdBest = SimdSSE2;
+
+#endif
+
+#ifdef NEU_SIMD_SSE2
+
+/**
+ * Computes sin(x) and cos(x) for every lane at once (Cephes polynomials,
+ * about 1e-7 absolute error for |x| < 8192).
+ */
+template <typename S>
+inline void simdSinCos(typename S::Float x, typename S::Float& sinOut,
+                       typename S::Float& cosOut) {
+  using Float = typename S::Float;
+  using Int = typename S::Int;
+
+  const Float signMask = S::asFloat(S::set1(static_cast<int>(0x80000000)));
+
+  Float sinSign = S::bitAnd(x, signMask);
+  x = S::bitAndNot(signMask, x);
+
+  //////////////////////////////////////
+  // RANGE REDUCTION TO [-PI/4, PI/4] //
+  //////////////////////////////////////
+
+  // OCTANT, ROUNDED UP TO AN EVEN NUMBER
+  Int octant = S::truncate(S::mul(x, S::set1(1.27323954473516f)));
+  octant = S::bitAnd(S::add(octant, S::set1(1)), S::set1(~1));
+  Float y = S::toFloat(octant);
+
+  Float sinSwap = S::asFloat(S::shiftLeft29(S::bitAnd(octant, S::set1(4))));
+  Float polyMask =
+      S::asFloat(S::equal(S::bitAnd(octant, S::set1(2)), S::set1(0)));
+  Float cosSign = S::asFloat(S::shiftLeft29(
+      S::bitAndNot(S::sub(octant, S::set1(2)), S::set1(4))));
+
+  sinSign = S::bitXor(sinSign, sinSwap);
+
+  // EXTENDED PRECISION PI/4 SUBTRACTION
+  x = S::sub(x, S::mul(y, S::set1(0.78515625f)));
+  x = S::sub(x, S::mul(y, S::set1(2.4187564849853515625e-4f)));
+  x = S::sub(x, S::mul(y, S::set1(3.77489497744594108e-8f)));
+
+  /////////////////
+  // POLYNOMIALS //
+  /////////////////
+
+  Float z = S::mul(x, x);
+
+  Float cosPoly = S::set1(2.443315711809948e-5f);
+  cosPoly = S::add(S::mul(cosPoly, z), S::set1(-1.388731625493765e-3f));
+  cosPoly = S::add(S::mul(cosPoly, z), S::set1(4.166664568298827e-2f));
+  cosPoly = S::mul(S::mul(cosPoly, z), z);
+  cosPoly = S::sub(cosPoly, S::mul(z, S::set1(0.5f)));
+  cosPoly = S::add(cosPoly, S::set1(1.0f));
+
+  Float sinPoly = S::set1(-1.9515295891e-4f);
+  sinPoly = S::add(S::mul(sinPoly, z), S::set1(8.3321608736e-3f));
+  sinPoly = S::add(S::mul(sinPoly, z), S::set1(-1.6666654611e-1f));
+  sinPoly = S::add(S::mul(S::mul(sinPoly, z), x), x);
+
+  // PICK THE POLYNOMIAL THAT MATCHES THE OCTANT
+  Float sinResult =
+      S::bitOr(S::bitAnd(polyMask, sinPoly), S::bitAndNot(polyMask, cosPoly));
+  Float cosResult =
+      S::bitOr(S::bitAnd(polyMask, cosPoly), S::bitAndNot(polyMask, sinPoly));
+
+  sinOut = S::bitXor(sinResult, sinSign);
+  cosOut = S::bitXor(cosResult, cosSign);
+}
+
+#endif
+
+}  // namespace Neu
@@ -0,0 +1,151 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+using namespace Neu;
+
+// IDENTIFIES THE POOL AND QUEUE OF THE CALLING WORKER THREAD
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local unsigned int currentWorker = 0;
+
+ThreadPool::ThreadPool(unsigned int workerCount) {
+  // ALWAYS KEEP ONE QUEUE SO TASKS CAN RUN ON THE CALLING THREAD
+  unsigned int queueCount = workerCount > 0 ? workerCount : 1;
+
+  for (unsigned int i = 0; i < queueCount; i++)
+    queues.push_back(std::make_unique<WorkerQueue>());
+
+  for (unsigned int i = 0; i < workerCount; i++)
+    threads.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    running = false;
+  }
+
+  wakeCondition.notify_all();
+
+  for (std::thread& thread : threads) thread.join();
+}
+
+void ThreadPool::submit(Task task) {
+  // WORKERS PUSH ONTO THEIR OWN QUEUE, OTHER THREADS SPREAD THE LOAD
+  unsigned int queueIndex =
+      currentPool == this
+          ? currentWorker
+          : nextQueue.fetch_add(1) % static_cast<unsigned int>(queues.size());
+
+  {
+    std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+    queues[queueIndex]->tasks.push_back(std::move(task));
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    pendingTasks++;
+  }
+
+  wakeCondition.notify_one();
+}
+
+bool ThreadPool::runPendingTask() {
+  Task task;
+
+  bool found = currentPool == this
+                   ? popTask(currentWorker, task) ||
+                         stealTask(currentWorker, task)
+                   : stealTask(nextQueue.load(), task);
+
+  if (!found) return false;
+
+  pendingTasks--;
+  task();
+
+  return true;
+}
+
+void ThreadPool::wait(const std::atomic<int>& counter) {
+  while (counter.load() > 0)
+    if (!runPendingTask()) std::this_thread::yield();
+}
+
+void ThreadPool::workerLoop(unsigned int workerIndex) {
+  currentPool = this;
+  currentWorker = workerIndex;
+
+  while (true) {
+    Task task;
+
+    if (popTask(workerIndex, task) || stealTask(workerIndex, task)) {
+      pendingTasks--;
+
+      auto start = std::chrono::steady_clock::now();
+      task();
+      queues[workerIndex]->busyNanoseconds +=
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count();
+
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleepMutex);
+
+    if (!running) return;
+
+    wakeCondition.wait(
+        lock, [this]() { return !running || pendingTasks.load() > 0; });
+  }
+}
+
+std::vector<float> ThreadPool::sampleUtilization() {
+  auto now = std::chrono::steady_clock::now();
+  double elapsed = static_cast<double>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - lastSampleTime)
+          .count());
+  lastSampleTime = now;
+
+  std::vector<float> utilization(threads.size(), 0.0f);
+
+  for (size_t i = 0; i < threads.size(); i++) {
+    long long busy = queues[i]->busyNanoseconds.exchange(0);
+    if (elapsed > 0.0)
+      utilization[i] = std::min(1.0f, static_cast<float>(busy / elapsed));
+  }
+
+  return utilization;
+}
+
+bool ThreadPool::popTask(unsigned int queueIndex, Task& task) {
+  WorkerQueue& queue = *queues[queueIndex];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+
+  if (queue.tasks.empty()) return false;
+
+  // NEWEST TASK FIRST, ITS DATA IS MOST LIKELY STILL IN CACHE
+  task = std::move(queue.tasks.back());
+  queue.tasks.pop_back();
+
+  return true;
+}
+
+bool ThreadPool::stealTask(unsigned int thiefIndex, Task& task) {
+  const unsigned int queueCount = static_cast<unsigned int>(queues.size());
+
+  for (unsigned int i = 0; i < queueCount; i++) {
+    WorkerQueue& queue = *queues[(thiefIndex + i) % queueCount];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.tasks.empty()) continue;
+
+    // OLDEST TASK FIRST, LEAVING THE OWNER ITS HOT TASKS
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+
+    return true;
+  }
+
+  return false;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Neu {
+
+/**
+ * Work-stealing thread pool shared by the engine's systems. Every worker owns
+ * a task deque; it pops its own tasks from the back and, when it runs dry,
+ * steals from the front of the other workers' deques. Tasks submitted from
+ * outside the pool (e.g. the main thread) are spread across the workers.
+ */
+class ThreadPool {
+ public:
+  using Task = std::function<void()>;
+
+  explicit ThreadPool(unsigned int workerCount);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  void submit(Task task);
+
+  /**
+   * Runs a single queued task on the calling thread. Returns false if there
+   * was no task to run.
+   */
+  bool runPendingTask();
+
+  /**
+   * Blocks until the counter reaches zero, running queued tasks on the
+   * calling thread in the meantime.
+   */
+  void wait(const std::atomic<int>& counter);
+
+  /**
+   * Calls func(index) for every index in [0, count) across the pool and the
+   * calling thread, and returns once all calls have finished.
+   */
+  template <typename Func>
+  void parallelFor(size_t count, Func&& func) {
+    if (count == 0) return;
+
+    if (count == 1 || threads.empty()) {
+      for (size_t index = 0; index < count; index++) func(index);
+      return;
+    }
+
+    std::atomic<int> remaining(static_cast<int>(count));
+
+    for (size_t index = 0; index < count; index++) {
+      submit([&func, &remaining, index]() {
+        func(index);
+        remaining--;
+      });
+    }
+
+    wait(remaining);
+  }
+
+  unsigned int getWorkerCount() const {
+    return static_cast<unsigned int>(threads.size());
+  }
+
+  /**
+   * Returns the fraction of time each worker spent running tasks since the
+   * previous call.
+   */
+  std::vector<float> sampleUtilization();
+
+ private:
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+
+    // TIME THE OWNING WORKER SPENT RUNNING TASKS
+    std::atomic<long long> busyNanoseconds{0};
+  };
+
+  void workerLoop(unsigned int workerIndex);
+
+  bool popTask(unsigned int queueIndex, Task& task);
+  bool stealTask(unsigned int thiefIndex, Task& task);
+
+  std::vector<std::unique_ptr<WorkerQueue>> queues;
+  std::vector<std::thread> threads;
+
+  std::atomic<unsigned int> nextQueue{0};
+  std::atomic<int> pendingTasks{0};
+  bool running = true;
+
+  std::mutex sleepMutex;
+  std::condition_variable wakeCondition;
+
+  std::chrono::steady_clock::time_point lastSampleTime =
+      std::chrono::steady_clock::now();
+};
+
+}  // namespace Neu
@@ -6,6 +6,7 @@
 
 #include "application.h"
 #include "core.h"
+#include "render/gl_extensions.h"
 
 #define CHECK_KEY_PRESSED(key) glfwGetKey(window, key) == GLFW_PRESS
 #define CHECK_MOUSE_BUTTON_PRESSED(button) \
@@ -16,14 +17,22 @@ using namespace Neu;
 
 WindowManager::WindowManager(Application* context) { this->context = context; }
 
-void WindowManager::initialize(int width, int height, std::string title) {
+void WindowManager::initialize(int width, int height, std::string title,
+                               bool headless) {
   this->width = width;
   this->height = height;
+  this->headless = headless;
 
   /////////////////
   // SET UP GLFW //
   /////////////////
 
+  // THE NULL PLATFORM WORKS WITHOUT A DISPLAY SERVER
+#ifdef GLFW_PLATFORM_NULL
+  if (headless && glfwPlatformSupported(GLFW_PLATFORM_NULL))
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+
   if (!glfwInit()) {
     Logger::error("Failed to initialize GLFW");
     exit(EXIT_FAILURE);
@@ -41,8 +50,24 @@ void WindowManager::initialize(int width, int height, std::string title) {
   // CREATE WINDOW //
   ///////////////////
 
+  if (headless) {
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    // ON THE NULL PLATFORM EGL USES A SURFACELESS DISPLAY
+#ifdef GLFW_PLATFORM_NULL
+    if (glfwGetPlatform() == GLFW_PLATFORM_NULL)
+      glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+#endif
+  }
+
   window = glfwCreateWindow(width, height, title.c_str(), NULL, NULL);
 
+  // PURE SOFTWARE RENDERING AS A LAST RESORT
+  if (window == NULL && headless) {
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+    window = glfwCreateWindow(width, height, title.c_str(), NULL, NULL);
+  }
+
   if (window == NULL) {
     const char* error;
     glfwGetError(&error);
@@ -65,16 +90,56 @@ void WindowManager::initialize(int width, int height, std::string title) {
   // https://github.com/Dav1dde/glad/wiki/C
   assert(gladLoadGL((GLADloadfunc)glfwGetProcAddress));
 
+  GLExtensions::load();
+
+  if (headless) {
+    Logger::info("Headless GL context: %s\n",
+                 (const char*)glGetString(GL_RENDERER));
+    createOffscreenFramebuffer();
+  }
+
   glViewport(0, 0, width, height);  // set viewport size
   glEnable(GL_DEPTH_TEST);          // enable depth testing
 }
 
+void WindowManager::createOffscreenFramebuffer() {
+  glGenRenderbuffers(1, &colorRenderbuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, colorRenderbuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+  glGenRenderbuffers(1, &depthRenderbuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, depthRenderbuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glGenFramebuffers(1, &framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, colorRenderbuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                            GL_RENDERBUFFER, depthRenderbuffer);
+
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    Logger::error("Failed to create the offscreen framebuffer\n");
+    glfwTerminate();
+    exit(EXIT_FAILURE);
+  }
+}
+
 void WindowManager::startFrame() {
   glfwPollEvents();
   updateInputStates();
+
+  if (headless) glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
 }
 
-void WindowManager::endFrame() { glfwSwapBuffers(window); }
+void WindowManager::endFrame() {
+  if (headless)
+    glFinish();
+  else
+    glfwSwapBuffers(window);
+}
 
 float WindowManager::getDeltaTime() {
   float currentFrame = static_cast<float>(glfwGetTime());
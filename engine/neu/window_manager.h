@@ -24,7 +24,15 @@ class WindowManager {
    */
   WindowManager(Application* context);
 
-  void initialize(int width, int height, std::string title);
+  /**
+   * Creates the window and the GL context. In headless mode nothing is shown:
+   * GLFW's null platform with an EGL (surfaceless) or OSMesa context is tried
+   * first, which needs neither a display nor a GPU (e.g. Mesa llvmpipe), then
+   * an invisible window. Frames are rendered into an offscreen framebuffer of
+   * the same size.
+   */
+  void initialize(int width, int height, std::string title,
+                  bool headless = false);
 
   /**
    * Returns the time between the current frame and the last frame.
@@ -41,7 +49,9 @@ class WindowManager {
 
   /**
    * Performs post-frame operations. It should
-   * be called at the end of each game loop iteration.
+   * be called at the end of each game loop iteration. In headless mode there
+   * is nothing to present, so it waits for the GPU to finish the frame
+   * instead.
    */
   void endFrame();
 
@@ -137,6 +147,14 @@ class WindowManager {
    */
   bool isCursorDisabled() const { return cursorDisabled; }
 
+  bool isHeadless() const { return headless; }
+
+  /**
+   * Returns the framebuffer frames are rendered into: the offscreen
+   * framebuffer in headless mode, otherwise 0 (the window).
+   */
+  unsigned int getFramebuffer() const { return framebuffer; }
+
  private:
   GLFWwindow* window;
   Application* context;
@@ -172,6 +190,15 @@ class WindowManager {
    */
   bool cursorDisabled = false;
 
+  bool headless = false;
+
+  // OFFSCREEN TARGET, ONLY CREATED IN HEADLESS MODE
+  unsigned int framebuffer = 0;
+  unsigned int colorRenderbuffer = 0;
+  unsigned int depthRenderbuffer = 0;
+
+  void createOffscreenFramebuffer();
+
   std::vector<std::function<void(int, int)>> framebufferSizeCallbacks;
   std::vector<std::function<void(int, int)>> keyCallbacks;
 